@@ -0,0 +1,64 @@
+#ifndef IO_BUFFER_POOL_H
+#define IO_BUFFER_POOL_H
+
+#include <fs/file.h>
+
+#include <atomic>
+#include <vector>
+
+//! A bounded, lock-free pool of equally sized write buffers
+/*!
+        Buffers are allocated with allocIoBuffer(). The producer takes them with acquire(), the consumer gives them back
+        with release() once the data is written. A buffer released while the pool is full is freed, so the pool never
+        holds more than capacity() free buffers. A pool buffer can also be freed with freeIoBuffer().
+*/
+class IoBufferPool
+{
+   public:
+    IoBufferPool(const size_t bufferSize, const unsigned capacity) : m_bufferSize(bufferSize), m_slots(capacity) {}
+
+    ~IoBufferPool()
+    {
+        for (auto& slot : m_slots) freeIoBuffer(slot.exchange(nullptr));
+    }
+
+    IoBufferPool(const IoBufferPool&) = delete;
+    IoBufferPool& operator=(const IoBufferPool&) = delete;
+
+    [[nodiscard]] size_t bufferSize() const { return m_bufferSize; }
+    [[nodiscard]] unsigned capacity() const { return static_cast<unsigned>(m_slots.size()); }
+
+    //! Take a free buffer of bufferSize() bytes, or allocate a new one if the pool is empty
+    uint8_t* acquire()
+    {
+        for (auto& slot : m_slots)
+        {
+            if (slot.load(std::memory_order_relaxed) == nullptr)
+                continue;
+            if (uint8_t* buffer = slot.exchange(nullptr, std::memory_order_acquire))
+                return buffer;
+        }
+        return allocIoBuffer(m_bufferSize);
+    }
+
+    //! Return a buffer taken with acquire()
+    void release(uint8_t* buffer)
+    {
+        if (buffer == nullptr)
+            return;
+        for (auto& slot : m_slots)
+        {
+            uint8_t* expected = nullptr;
+            if (slot.load(std::memory_order_relaxed) == nullptr &&
+                slot.compare_exchange_strong(expected, buffer, std::memory_order_release, std::memory_order_relaxed))
+                return;
+        }
+        freeIoBuffer(buffer);
+    }
+
+   private:
+    size_t m_bufferSize;
+    std::vector<std::atomic<uint8_t*>> m_slots;  // nullptr for an empty slot
+};
+
+#endif  // IO_BUFFER_POOL_H
@@ -0,0 +1,270 @@
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+//! Size of a cache line. The positions of the producers and of the consumer are kept in different lines
+constexpr size_t RING_QUEUE_LINE_SIZE = 64;
+
+//! Sleeping of the ring queue threads while the queue is empty or full
+/*!
+        A thread which has to wait registers itself and sleeps on a condition variable. The other side only takes the
+        mutex when somebody is registered, so the queue stays lock-free as long as nobody waits.
+*/
+class RingQueueWaiter
+{
+   public:
+    template <typename Pred>
+    void waitNotEmpty(Pred ready)
+    {
+        wait(m_emptyWaiters, m_notEmpty, ready);
+    }
+
+    template <typename Pred>
+    void waitNotFull(Pred ready)
+    {
+        wait(m_fullWaiters, m_notFull, ready);
+    }
+
+    void notifyNotEmpty() { notify(m_emptyWaiters, m_notEmpty); }
+    void notifyNotFull() { notify(m_fullWaiters, m_notFull); }
+
+   private:
+    template <typename Pred>
+    void wait(std::atomic<int>& waiters, std::condition_variable& cond, Pred ready)
+    {
+        std::unique_lock lk(m_mtx);
+        waiters.fetch_add(1, std::memory_order_relaxed);
+        // pairs with the fence in notify(): either the waiter sees the new state or the notifier sees the waiter
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!ready()) cond.wait(lk);
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify(const std::atomic<int>& waiters, std::condition_variable& cond)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) == 0)
+            return;
+        // the waiter holds the mutex until it sleeps, so the notification can't be lost
+        std::lock_guard lk(m_mtx);
+        cond.notify_one();
+    }
+
+    std::mutex m_mtx;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::atomic<int> m_emptyWaiters{0};
+    std::atomic<int> m_fullWaiters{0};
+};
+
+inline size_t ringQueueCapacity(const size_t capacity)
+{
+    size_t rez = 1;
+    while (rez < capacity) rez <<= 1;
+    return rez;
+}
+
+//! A bounded lock-free queue for one producer and one consumer thread
+/*!
+        The capacity is rounded up to a power of two. push() blocks while the queue is full and pop() while it is
+        empty. tryPush() and tryPop() never block. front() and the pop functions must only be called by the consumer.
+*/
+template <typename T>
+class SpscQueue
+{
+   public:
+    explicit SpscQueue(const size_t capacity)
+        : m_mask(ringQueueCapacity(capacity) - 1), m_buffer(new T[m_mask + 1]), m_tail(0), m_headCache(0), m_head(0),
+          m_tailCache(0)
+    {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    [[nodiscard]] size_t capacity() const { return m_mask + 1; }
+    [[nodiscard]] size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] bool full() const { return size() > m_mask; }
+
+    bool tryPush(const T& val)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache > m_mask)
+        {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache > m_mask)
+                return false;
+        }
+        m_buffer[tail & m_mask] = val;
+        m_tail.store(tail + 1, std::memory_order_release);
+        m_waiter.notifyNotEmpty();
+        return true;
+    }
+
+    void push(const T& val)
+    {
+        while (!tryPush(val)) m_waiter.waitNotFull([this] { return !full(); });
+    }
+
+    //! The oldest element or nullptr if the queue is empty. Valid until it is popped
+    T* front()
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tailCache)
+        {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tailCache)
+                return nullptr;
+        }
+        return &m_buffer[head & m_mask];
+    }
+
+    bool tryPop(T& val)
+    {
+        T* data = front();
+        if (data == nullptr)
+            return false;
+        val = std::move(*data);
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        m_waiter.notifyNotFull();
+        return true;
+    }
+
+    T pop()
+    {
+        T val;
+        while (!tryPop(val)) m_waiter.waitNotEmpty([this] { return !empty(); });
+        return val;
+    }
+
+   private:
+    const size_t m_mask;
+    const std::unique_ptr<T[]> m_buffer;
+    alignas(RING_QUEUE_LINE_SIZE) std::atomic<size_t> m_tail;  // written by the producer
+    size_t m_headCache;                                         // last m_head seen by the producer
+    alignas(RING_QUEUE_LINE_SIZE) std::atomic<size_t> m_head;  // written by the consumer
+    size_t m_tailCache;                                         // last m_tail seen by the consumer
+    alignas(RING_QUEUE_LINE_SIZE) RingQueueWaiter m_waiter;
+};
+
+//! A bounded lock-free queue for any number of producer threads and one consumer thread
+/*!
+        Each slot has a sequence number which tells whether it is free for the producer claiming its position or
+        holds the data for the consumer. The capacity is rounded up to a power of two. push() blocks while the queue
+        is full and pop() while it is empty. front() and the pop functions must only be called by the consumer.
+*/
+template <typename T>
+class MpscQueue
+{
+   public:
+    explicit MpscQueue(const size_t capacity)
+        : m_mask(ringQueueCapacity(capacity) - 1), m_cells(new Cell[m_mask + 1]), m_tail(0), m_head(0)
+    {
+        for (size_t i = 0; i <= m_mask; ++i) m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    [[nodiscard]] size_t capacity() const { return m_mask + 1; }
+    [[nodiscard]] size_t size() const
+    {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+    //! True if the consumer has nothing to pop. Elements which are still being pushed are not counted
+    [[nodiscard]] bool empty() const
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        return m_cells[head & m_mask].seq.load(std::memory_order_acquire) != head + 1;
+    }
+    [[nodiscard]] bool full() const
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        return m_cells[tail & m_mask].seq.load(std::memory_order_acquire) < tail;
+    }
+
+    bool tryPush(const T& val)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;  // the slot still holds the data pushed one round before
+            else
+                pos = m_tail.load(std::memory_order_relaxed);
+        }
+        cell->data = val;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        m_waiter.notifyNotEmpty();
+        return true;
+    }
+
+    void push(const T& val)
+    {
+        while (!tryPush(val)) m_waiter.waitNotFull([this] { return !full(); });
+    }
+
+    //! The oldest element or nullptr if the queue is empty. Valid until it is popped
+    T* front()
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        Cell& cell = m_cells[head & m_mask];
+        return cell.seq.load(std::memory_order_acquire) == head + 1 ? &cell.data : nullptr;
+    }
+
+    bool tryPop(T& val)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        Cell& cell = m_cells[head & m_mask];
+        if (cell.seq.load(std::memory_order_acquire) != head + 1)
+            return false;
+        val = std::move(cell.data);
+        cell.seq.store(head + m_mask + 1, std::memory_order_release);
+        m_head.store(head + 1, std::memory_order_release);
+        m_waiter.notifyNotFull();
+        return true;
+    }
+
+    T pop()
+    {
+        T val;
+        while (!tryPop(val)) m_waiter.waitNotEmpty([this] { return !empty(); });
+        return val;
+    }
+
+   private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    const size_t m_mask;
+    const std::unique_ptr<Cell[]> m_cells;
+    alignas(RING_QUEUE_LINE_SIZE) std::atomic<size_t> m_tail;  // next position claimed by a producer
+    alignas(RING_QUEUE_LINE_SIZE) std::atomic<size_t> m_head;  // next position read by the consumer
+    alignas(RING_QUEUE_LINE_SIZE) RingQueueWaiter m_waiter;
+};
+
+#endif  // RING_QUEUE_H
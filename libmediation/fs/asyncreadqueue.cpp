@@ -0,0 +1,222 @@
+#include "asyncreadqueue.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING
+#endif
+
+#ifdef HAVE_IO_URING
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace
+{
+struct IoUring
+{
+    int fd = -1;
+
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned* sqArray = nullptr;
+
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    unsigned toSubmit = 0;
+
+    ~IoUring()
+    {
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing)
+            munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED)
+            munmap(sqRing, sqRingSize);
+        if (fd != -1)
+            ::close(fd);
+    }
+};
+
+unsigned loadAcquire(const unsigned* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+void storeRelease(unsigned* p, const unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+template <typename T>
+T* ringPtr(void* ring, const unsigned offset)
+{
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+IoUring* createRing(const unsigned depth)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    const int fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+    if (fd < 0)
+        return nullptr;
+
+    auto ring = new IoUring();
+    ring->fd = fd;
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+        ring->sqRingSize = ring->cqRingSize = std::max(ring->sqRingSize, ring->cqRingSize);
+
+    ring->sqRing =
+        mmap(nullptr, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sqRing == MAP_FAILED)
+    {
+        delete ring;
+        return nullptr;
+    }
+    if (singleMmap)
+        ring->cqRing = ring->sqRing;
+    else
+        ring->cqRing =
+            mmap(nullptr, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqes = static_cast<io_uring_sqe*>(
+        mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (ring->cqRing == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        delete ring;
+        return nullptr;
+    }
+
+    ring->sqHead = ringPtr<unsigned>(ring->sqRing, params.sq_off.head);
+    ring->sqTail = ringPtr<unsigned>(ring->sqRing, params.sq_off.tail);
+    ring->sqMask = *ringPtr<unsigned>(ring->sqRing, params.sq_off.ring_mask);
+    ring->sqEntries = *ringPtr<unsigned>(ring->sqRing, params.sq_off.ring_entries);
+    ring->sqArray = ringPtr<unsigned>(ring->sqRing, params.sq_off.array);
+
+    ring->cqHead = ringPtr<unsigned>(ring->cqRing, params.cq_off.head);
+    ring->cqTail = ringPtr<unsigned>(ring->cqRing, params.cq_off.tail);
+    ring->cqMask = *ringPtr<unsigned>(ring->cqRing, params.cq_off.ring_mask);
+    ring->cqes = ringPtr<io_uring_cqe>(ring->cqRing, params.cq_off.cqes);
+    return ring;
+}
+
+IoUring* toRing(void* impl) { return static_cast<IoUring*>(impl); }
+}  // namespace
+
+AsyncReadQueue::AsyncReadQueue() : m_impl(nullptr), m_depth(0) {}
+
+AsyncReadQueue::~AsyncReadQueue() { close(); }
+
+bool AsyncReadQueue::open(const unsigned int depth)
+{
+    close();
+    if (depth == 0)
+        return false;
+    IoUring* ring = createRing(depth);
+    if (!ring)
+        return false;
+    m_impl = ring;
+    m_depth = ring->sqEntries;
+    return true;
+}
+
+void AsyncReadQueue::close()
+{
+    delete toRing(m_impl);
+    m_impl = nullptr;
+    m_depth = 0;
+}
+
+bool AsyncReadQueue::isOpen() const { return m_impl != nullptr; }
+
+bool AsyncReadQueue::prepareRead(void* handle, void* buffer, const uint32_t count, const int64_t offset,
+                                 const uint64_t userData)
+{
+    IoUring* ring = toRing(m_impl);
+    if (!ring)
+        return false;
+    const unsigned tail = *ring->sqTail;
+    if (tail - loadAcquire(ring->sqHead) >= ring->sqEntries)
+        return false;
+
+    const unsigned index = tail & ring->sqMask;
+    io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = static_cast<int>(reinterpret_cast<std::intptr_t>(handle));
+    sqe->addr = reinterpret_cast<std::uintptr_t>(buffer);
+    sqe->len = count;
+    sqe->off = static_cast<uint64_t>(offset);
+    sqe->user_data = userData;
+    ring->sqArray[index] = index;
+    storeRelease(ring->sqTail, tail + 1);
+    ring->toSubmit++;
+    return true;
+}
+
+bool AsyncReadQueue::submit(const unsigned int minComplete)
+{
+    IoUring* ring = toRing(m_impl);
+    if (!ring)
+        return false;
+    while (true)
+    {
+        const long rez = syscall(__NR_io_uring_enter, ring->fd, ring->toSubmit, minComplete,
+                                 minComplete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (rez >= 0)
+        {
+            ring->toSubmit -= static_cast<unsigned>(rez);
+            return true;
+        }
+        if (errno != EINTR)
+            return false;
+    }
+}
+
+bool AsyncReadQueue::getCompletion(uint64_t& userData, int& result)
+{
+    IoUring* ring = toRing(m_impl);
+    if (!ring)
+        return false;
+    const unsigned head = *ring->cqHead;
+    if (head == loadAcquire(ring->cqTail))
+        return false;
+    const io_uring_cqe& cqe = ring->cqes[head & ring->cqMask];
+    userData = cqe.user_data;
+    result = cqe.res;
+    storeRelease(ring->cqHead, head + 1);
+    return true;
+}
+
+#else
+
+AsyncReadQueue::AsyncReadQueue() : m_impl(nullptr), m_depth(0) {}
+
+AsyncReadQueue::~AsyncReadQueue() = default;
+
+bool AsyncReadQueue::open(unsigned int) { return false; }
+
+void AsyncReadQueue::close() {}
+
+bool AsyncReadQueue::isOpen() const { return false; }
+
+bool AsyncReadQueue::prepareRead(void*, void*, uint32_t, int64_t, uint64_t) { return false; }
+
+bool AsyncReadQueue::submit(unsigned int) { return false; }
+
+bool AsyncReadQueue::getCompletion(uint64_t&, int&) { return false; }
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef LIBMEDIATION_ASYNC_READ_QUEUE_H
+#define LIBMEDIATION_ASYNC_READ_QUEUE_H
+
+#include <cstdint>
+
+//! A queue of positional file reads which are executed by the OS in parallel.
+/*!
+        On Linux the queue is backed by io_uring. On other platforms, or if the kernel does not allow io_uring,
+        open() fails and the caller is expected to fall back to blocking reads.
+*/
+class AsyncReadQueue
+{
+   public:
+    AsyncReadQueue();
+    ~AsyncReadQueue();
+
+    //! Create the queue
+    /*!
+            \param depth Maximum number of reads which may be in flight at the same time.
+            \return true if the queue was created, false if asynchronous reads are not supported.
+    */
+    bool open(unsigned int depth);
+    void close();
+    [[nodiscard]] bool isOpen() const;
+    [[nodiscard]] unsigned int depth() const { return m_depth; }
+
+    //! Queue a read request. It is not passed to the OS until submit() is called.
+    /*!
+            \param handle Native file handle, as returned by File::nativeHandle().
+            \param userData Arbitrary value returned together with the result of the read.
+            \return false if the queue is full.
+    */
+    bool prepareRead(void* handle, void* buffer, uint32_t count, int64_t offset, uint64_t userData);
+    //! Pass all queued requests to the OS and wait until at least minComplete requests have finished.
+    /*!
+            \return false in case of an error.
+    */
+    bool submit(unsigned int minComplete);
+    //! Get the result of a finished read request.
+    /*!
+            \param result Number of bytes read, or a negative error code.
+            \return false if there are no finished requests.
+    */
+    bool getCompletion(uint64_t& userData, int& result);
+
+   private:
+    void* m_impl;
+    unsigned int m_depth;
+};
+
+#endif  // LIBMEDIATION_ASYNC_READ_QUEUE_H
@@ -15,6 +15,20 @@ bool fileExists(const std::string& fileName);
 
 uint64_t getFileSize(const std::string& fileName);
 
+//! Attributes which change when a file is modified or replaced
+struct FileStamp
+{
+    uint64_t size;
+    int64_t modTime;  // last modification time in nanoseconds, in the OS epoch
+    uint64_t device;  // volume serial number on Windows
+    uint64_t inode;   // file index on Windows
+};
+
+bool getFileStamp(const std::string& fileName, FileStamp* stamp);
+
+/** directory for the cached data of the current user, with a trailing separator. Empty if it is unknown */
+std::string getUserCacheDir();
+
 /** remove file. cerr contains error code */
 bool deleteFile(const std::string& fileName);
 
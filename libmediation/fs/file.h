@@ -1,6 +1,8 @@
 #ifndef LIBMEDIATION_FILE_H
 #define LIBMEDIATION_FILE_H
 
+#include <new>
+
 #include "../types/types.h"
 
 class AbstractStream
@@ -15,18 +17,51 @@ class AbstractStream
     static constexpr unsigned int ofOpenExisting = 8;  // do not create file if absent
     static constexpr unsigned int ofCreateNew = 16;    // create new file. Return error If file exist
     static constexpr unsigned int ofNoTruncate = 32;   // keep file data while opening
+    static constexpr unsigned int ofDirect = 64;       // bypass the OS page cache for aligned writes (unix only)
 
     virtual bool open(const char* fName, unsigned int oflag, unsigned int systemDependentFlags = 0) = 0;
     virtual bool close() = 0;
     [[nodiscard]] virtual int64_t size() const = 0;
 };
 
+//! A buffer passed to AbstractOutputStream::writev()
+struct IoSlice
+{
+    const void* data;
+    uint32_t size;
+};
+
 class AbstractOutputStream : public AbstractStream
 {
    public:
     virtual int write(const void* buffer, uint32_t count) = 0;
     int write(const std::vector<std::uint8_t>& data) { return write(data.data(), static_cast<uint32_t>(data.size())); }
+    //! Write several buffers one after another
+    /*!
+            The default implementation calls write() for each buffer. Streams which can do it in one system call
+            override it.
+            \return The number of bytes written, less than the total size if a write failed. -1 if nothing was written.
+    */
+    virtual int64_t writev(const IoSlice* slices, int count)
+    {
+        int64_t total = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            const int rez = write(slices[i].data, slices[i].size);
+            if (rez > 0)
+                total += rez;
+            if (rez != static_cast<int>(slices[i].size))
+                return total > 0 ? total : rez;
+        }
+        return total;
+    }
     virtual void sync() = 0;
+    //! Start the writeback of every windowSize bytes written and drop them from the page cache behind the writer, so
+    //! the amount of dirty memory stays bounded. 0 disables it
+    virtual void setWriteback(uint32_t) {}
+    //! Reserve disk space for a file which is expected to grow to about size bytes, so it is stored contiguously.
+    //! The file size does not change, the reserved space which is not used is released when the file is closed
+    virtual void preallocate(int64_t) {}
 };
 
 //! A class which represents an interface for working with files.
@@ -82,11 +117,14 @@ class File : public AbstractOutputStream
        full).
     */
     int write(const void* buffer, uint32_t count) override;
+    int64_t writev(const IoSlice* slices, int count) override;
     //! Write changes into the disk.
     /*!
-            Write changes into the disk
+            Write changes of this file into the disk
     */
     void sync() override;
+    void setWriteback(uint32_t windowSize) override;
+    void preallocate(int64_t size) override;
 
     //! Check if the file is open.
     /*!
@@ -125,12 +163,78 @@ class File : public AbstractOutputStream
 
     uint64_t pos() const { return m_pos; }
 
+    //! Get the OS handle of the file
+    /*!
+            \return File descriptor in the unix implementation, HANDLE in the win32 implementation.
+    */
+    void* nativeHandle() const { return m_impl; }
+
    private:
     void* m_impl;
     std::string m_name;
     mutable int64_t m_pos;
+
+    // ofDirect state. Writes of whole sectors from an aligned buffer at an aligned file offset bypass the page cache,
+    // any other write (e.g. the tail of the file) is done through it.
+    uint32_t m_directIoAlign = 0;            // alignment required by the file system, 0 if not opened with ofDirect
+    bool m_directIo = false;                 // O_DIRECT is currently set for the descriptor
+    mutable bool m_directIoAligned = false;  // the current file offset is aligned
+
+    // rolling writeback state (unix only). The writeback of [m_writebackStart, m_writebackEnd) is started once it
+    // reaches m_writeback bytes, [m_writebackPrev, m_writebackStart) is the previous window which is written back
+    uint32_t m_writeback = 0;
+    mutable int64_t m_writebackPrev = 0;
+    mutable int64_t m_writebackStart = 0;
+    mutable int64_t m_writebackEnd = 0;
+
+    // preallocation state (linux only). Disk space is reserved up to m_preallocEnd, the reservation is extended
+    // when the written data m_preallocPos reaches it. 0 if there is no reservation
+    int64_t m_preallocEnd = 0;
+    int64_t m_preallocPos = 0;
+
+    void writeback(uint32_t count);
+    void extendPreallocation(uint32_t count);
 };
 
+//! Output file name which stands for the standard output
+constexpr char STDOUT_FILE_NAME[] = "-";
+
+//! The standard output of the process, e.g. a pipe to another program
+/*!
+        The file name passed to open() is ignored. The stream can't seek: the data is always appended to what was
+        written before, so it can only be reopened with ofAppend. close() keeps the standard output open.
+*/
+class StdoutStream final : public AbstractOutputStream
+{
+   public:
+    bool open(const char* fName, unsigned int oflag, unsigned int systemDependentFlags = 0) override;
+    bool close() override { return true; }
+    //! Number of bytes written so far
+    [[nodiscard]] int64_t size() const override { return m_written; }
+    int write(const void* buffer, uint32_t count) override;
+    void sync() override {}
+
+   private:
+    int64_t m_written = 0;
+};
+
+//! Input file name which stands for the standard input. A File opened for reading with this name reads it
+constexpr char STDIN_FILE_NAME[] = "-";
+
+//! Check if an input file can only be read sequentially, e.g. the standard input or a named pipe
+bool isPipeInput(const char* fName);
+
+//! Alignment of the buffers passed to a file opened with ofDirect
+constexpr size_t IO_BUFFER_ALIGNMENT = 4096;
+
+//! Allocate a write buffer which can be passed to a file opened with ofDirect. Free it with freeIoBuffer()
+inline uint8_t* allocIoBuffer(const size_t size)
+{
+    return static_cast<uint8_t*>(::operator new[](size, std::align_val_t(IO_BUFFER_ALIGNMENT)));
+}
+
+inline void freeIoBuffer(uint8_t* buffer) { ::operator delete[](buffer, std::align_val_t(IO_BUFFER_ALIGNMENT)); }
+
 class FileFactory
 {
    public:
@@ -3,6 +3,7 @@
 #include "../directory.h"
 #include "../directory_priv.h"
 
+#include <cstdlib>
 #include <dirent.h>
 #include <fnmatch.h>
 #include <sys/stat.h>
@@ -34,6 +35,36 @@ uint64_t getFileSize(const std::string& fileName)
     return res ? static_cast<uint64_t>(fileStat.st_size) : 0;
 }
 
+bool getFileStamp(const std::string& fileName, FileStamp* stamp)
+{
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat) != 0)
+        return false;
+    stamp->size = static_cast<uint64_t>(fileStat.st_size);
+#ifdef __APPLE__
+    const auto& modTime = fileStat.st_mtimespec;
+#else
+    const auto& modTime = fileStat.st_mtim;
+#endif
+    stamp->modTime = static_cast<int64_t>(modTime.tv_sec) * 1000000000 + modTime.tv_nsec;
+    stamp->device = static_cast<uint64_t>(fileStat.st_dev);
+    stamp->inode = static_cast<uint64_t>(fileStat.st_ino);
+    return true;
+}
+
+string getUserCacheDir()
+{
+    const char* home = getenv("HOME");
+#ifdef __APPLE__
+    return home && *home ? string(home) + "/Library/Caches/" : string();
+#else
+    const char* cacheHome = getenv("XDG_CACHE_HOME");
+    if (cacheHome && *cacheHome == '/')
+        return string(cacheHome) + '/';
+    return home && *home ? string(home) + "/.cache/" : string();
+#endif
+}
+
 bool createDir(const std::string& dirName, bool createParentDirs)
 {
     auto ok = preCreateDir([](auto) { return false; },
@@ -35,6 +35,34 @@ uint64_t getFileSize(const std::string& fileName)
     return 0;
 }
 
+bool getFileStamp(const std::string& fileName, FileStamp* stamp)
+{
+    const HANDLE handle = CreateFile(toWide(fileName).data(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                     nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    BY_HANDLE_FILE_INFORMATION info;
+    const bool rez = GetFileInformationByHandle(handle, &info) != 0;
+    CloseHandle(handle);
+    if (!rez)
+        return false;
+    stamp->size = static_cast<uint64_t>(info.nFileSizeHigh) << 32 | info.nFileSizeLow;
+    // FILETIME is measured in 100 ns units
+    stamp->modTime =
+        static_cast<int64_t>(static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32 |
+                             info.ftLastWriteTime.dwLowDateTime) *
+        100;
+    stamp->device = info.dwVolumeSerialNumber;
+    stamp->inode = static_cast<uint64_t>(info.nFileIndexHigh) << 32 | info.nFileIndexLow;
+    return true;
+}
+
+string getUserCacheDir()
+{
+    const wchar_t* localAppData = _wgetenv(L"LOCALAPPDATA");
+    return localAppData && *localAppData ? toUtf8(localAppData) + '\\' : string();
+}
+
 bool createDir(const std::string& dirName, const bool createParentDirs)
 {
     const bool ok = preCreateDir(
@@ -10,9 +10,12 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <sstream>
 
 #include "../directory.h"
@@ -50,6 +53,42 @@ int makeUnixOpenFlags(unsigned int oflag)
         sysFlags |= O_CREAT | O_EXCL;
     return sysFlags;
 }
+
+bool setDirectIo(const int fd, const bool value)
+{
+#if defined(O_DIRECT)
+    const int flags = fcntl(fd, F_GETFL);
+    return flags != -1 && fcntl(fd, F_SETFL, value ? flags | O_DIRECT : flags & ~O_DIRECT) == 0;
+#elif defined(F_NOCACHE)
+    return fcntl(fd, F_NOCACHE, value ? 1 : 0) != -1;
+#else
+    return false;
+#endif
+}
+
+// offset and length alignment required for O_DIRECT. 0 if the file system does not support it
+uint32_t directIoAlignment(const int fd)
+{
+#if defined(__linux__) && defined(STATX_DIOALIGN)
+    struct statx stx;
+    if (statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN))
+    {
+        if (stx.stx_dio_offset_align == 0 || stx.stx_dio_mem_align > IO_BUFFER_ALIGNMENT)
+            return 0;
+        return std::max(stx.stx_dio_offset_align, stx.stx_dio_mem_align);
+    }
+#endif
+    return IO_BUFFER_ALIGNMENT;
+}
+
+bool isAligned(const void* buffer, const uint32_t count, const uint32_t align)
+{
+    return ((reinterpret_cast<std::uintptr_t>(buffer) | count) & (align - 1)) == 0;
+}
+
+// the reservation is extended by a quarter of the data written so far, within these limits
+constexpr int64_t MIN_PREALLOC_STEP = 16 * 1024 * 1024;
+constexpr int64_t MAX_PREALLOC_STEP = 256 * 1024 * 1024;
 }  // namespace
 
 File::File() : m_impl(from_fd(-1)), m_pos(0) {}
@@ -80,15 +119,44 @@ bool File::open(const char* fName, unsigned int oflag, unsigned int systemDepend
     if (isOpen())
         close();
 
-    int sysFlags = makeUnixOpenFlags(oflag);
-    createDir(extractFileDir(fName), true);
-    auto fd = ::open(fName, sysFlags | systemDependentFlags, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+    int fd;
+    if (oflag == ofRead && strcmp(fName, STDIN_FILE_NAME) == 0)
+    {
+        // a copy of the descriptor, so closing the file keeps the standard input open
+        fd = dup(STDIN_FILENO);
+    }
+    else
+    {
+        int sysFlags = makeUnixOpenFlags(oflag);
+        createDir(extractFileDir(fName), true);
+        fd = ::open(fName, sysFlags | systemDependentFlags, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+    }
     m_impl = from_fd(fd);
+    m_directIoAlign = 0;
+    m_directIo = false;
+    m_writeback = 0;
+    if (fd != -1 && (oflag & ofDirect))
+    {
+        m_directIoAlign = directIoAlignment(fd);
+        struct stat st;
+        m_directIoAligned = !(oflag & ofAppend) || (fstat(fd, &st) == 0 && st.st_size % m_directIoAlign == 0);
+        if (m_directIoAlign && !setDirectIo(fd, true))
+            m_directIoAlign = 0;
+        m_directIo = m_directIoAlign != 0;
+    }
     return fd != -1;
 }
 
 bool File::close()
 {
+    if (m_preallocEnd)
+    {
+        // release the space reserved after the end of the file
+        m_preallocEnd = 0;
+        struct stat st;
+        if (fstat(to_fd(m_impl), &st) == 0)
+            ftruncate(to_fd(m_impl), st.st_size);
+    }
     if (::close(to_fd(m_impl)) == 0)
     {
         m_impl = from_fd(-1);
@@ -111,7 +179,71 @@ int File::write(const void* buffer, uint32_t count)
     if (!isOpen())
         return -1;
     m_pos += count;
-    return ::write(to_fd(m_impl), buffer, count);
+    const int fd = to_fd(m_impl);
+    if (m_directIoAlign)
+    {
+        const bool direct = m_directIoAligned && isAligned(buffer, count, m_directIoAlign);
+        if (direct != m_directIo && setDirectIo(fd, direct))
+            m_directIo = direct;
+        m_directIoAligned = m_directIoAligned && count % m_directIoAlign == 0;
+        if (m_directIo)
+        {
+            const int rez = ::write(fd, buffer, count);
+            if (rez != -1 || errno != EINVAL)
+            {
+                if (rez > 0 && m_writeback)
+                    writeback(rez);
+                if (rez > 0 && m_preallocEnd)
+                    extendPreallocation(rez);
+                return rez;
+            }
+            // the device requires a larger alignment than reported. Don't try to bypass the cache any more
+            setDirectIo(fd, false);
+            m_directIoAlign = 0;
+            m_directIo = false;
+        }
+    }
+    const int rez = ::write(fd, buffer, count);
+    if (rez > 0 && m_writeback)
+        writeback(rez);
+    if (rez > 0 && m_preallocEnd)
+        extendPreallocation(rez);
+    return rez;
+}
+
+int64_t File::writev(const IoSlice* slices, const int count)
+{
+    // O_DIRECT is switched on and off per buffer
+    if (!isOpen() || m_directIoAlign)
+        return AbstractOutputStream::writev(slices, count);
+
+    iovec iov[IOV_MAX];
+    int64_t total = 0;
+    for (int first = 0; first < count;)
+    {
+        const int n = std::min(count - first, IOV_MAX);
+        size_t size = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            iov[i].iov_base = const_cast<void*>(slices[first + i].data);
+            iov[i].iov_len = slices[first + i].size;
+            size += slices[first + i].size;
+        }
+        const ssize_t rez = ::writev(to_fd(m_impl), iov, n);
+        if (rez > 0)
+        {
+            total += rez;
+            m_pos += rez;
+            if (m_writeback)
+                writeback(static_cast<uint32_t>(rez));
+            if (m_preallocEnd)
+                extendPreallocation(static_cast<uint32_t>(rez));
+        }
+        if (rez != static_cast<ssize_t>(size))
+            return total > 0 ? total : -1;
+        first += n;
+    }
+    return total;
 }
 
 bool File::isOpen() const { return to_fd(m_impl) != -1; }
@@ -150,11 +282,125 @@ int64_t File::seek(const int64_t offset, const SeekMethod whence) const
         break;
     }
     m_pos = offset;
-    return lseek(to_fd(m_impl), offset, sWhence);
+    const int64_t rez = lseek(to_fd(m_impl), offset, sWhence);
+    if (m_directIoAlign)
+        m_directIoAligned = rez != -1 && rez % m_directIoAlign == 0;
+    if (rez != -1)
+        m_writebackPrev = m_writebackStart = m_writebackEnd = rez;
+    return rez;
 }
 
 bool File::truncate(const uint64_t newFileSize) const { return ftruncate(to_fd(m_impl), newFileSize) == 0; }
 
-void File::sync() { ::sync(); }
+void File::sync()
+{
+#if defined(__APPLE__)
+    fcntl(to_fd(m_impl), F_FULLFSYNC);
+#elif defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+    fdatasync(to_fd(m_impl));
+#else
+    fsync(to_fd(m_impl));
+#endif
+}
+
+void File::setWriteback(const uint32_t windowSize)
+{
+    m_writeback = windowSize;
+    const int fd = to_fd(m_impl);
+    // with O_APPEND the next write goes to the end of the file, whatever the current offset is
+    const bool append = isOpen() && (fcntl(fd, F_GETFL) & O_APPEND);
+    const int64_t pos = isOpen() ? lseek(fd, 0, append ? SEEK_END : SEEK_CUR) : 0;
+    m_writebackPrev = m_writebackStart = m_writebackEnd = std::max<int64_t>(pos, 0);
+}
+
+void File::writeback(const uint32_t count)
+{
+    m_writebackEnd += count;
+    if (m_writebackEnd - m_writebackStart < m_writeback)
+        return;
+#if defined(__linux__)
+    // start the writeback of the new window, then wait for the previous one and drop it from the page cache. At most
+    // two windows of this file are dirty or under writeback at any time
+    const int fd = to_fd(m_impl);
+    sync_file_range(fd, m_writebackStart, m_writebackEnd - m_writebackStart, SYNC_FILE_RANGE_WRITE);
+    if (m_writebackPrev < m_writebackStart)
+    {
+        sync_file_range(fd, m_writebackPrev, m_writebackStart - m_writebackPrev,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(fd, m_writebackPrev, m_writebackStart - m_writebackPrev, POSIX_FADV_DONTNEED);
+    }
+#endif
+    m_writebackPrev = m_writebackStart;
+    m_writebackStart = m_writebackEnd;
+}
+
+bool isPipeInput(const char* fName)
+{
+    if (strcmp(fName, STDIN_FILE_NAME) == 0)
+    {
+        struct stat st;
+        return fstat(STDIN_FILENO, &st) != 0 || !S_ISREG(st.st_mode);
+    }
+    struct stat st;
+    return stat(fName, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+bool StdoutStream::open(const char*, const unsigned int oflag, unsigned int)
+{
+    return m_written == 0 || (oflag & ofAppend);
+}
+
+int StdoutStream::write(const void* buffer, const uint32_t count)
+{
+    // a pipe may take only a part of the data
+    auto data = static_cast<const uint8_t*>(buffer);
+    uint32_t rest = count;
+    while (rest > 0)
+    {
+        const ssize_t rez = ::write(STDOUT_FILENO, data, rest);
+        if (rez == -1 && errno == EINTR)
+            continue;
+        if (rez <= 0)
+            return rest == count ? -1 : static_cast<int>(count - rest);
+        data += rez;
+        rest -= static_cast<uint32_t>(rez);
+    }
+    m_written += count;
+    return static_cast<int>(count);
+}
+
+void File::preallocate(const int64_t size)
+{
+    m_preallocEnd = 0;
+#if defined(__linux__)
+    const int fd = to_fd(m_impl);
+    struct stat st;
+    if (!isOpen() || fstat(fd, &st) != 0 || size <= st.st_size)
+        return;
+    // FALLOC_FL_KEEP_SIZE: the file does not look longer than the data written into it, whatever the estimate was
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, st.st_size, size - st.st_size) == 0)
+    {
+        m_preallocPos = st.st_size;
+        m_preallocEnd = size;
+    }
+#endif
+}
+
+void File::extendPreallocation(const uint32_t count)
+{
+    m_preallocPos += count;
+    if (m_preallocPos < m_preallocEnd)
+        return;
+#if defined(__linux__)
+    const int64_t step = std::clamp(m_preallocPos / 4, MIN_PREALLOC_STEP, MAX_PREALLOC_STEP);
+    if (fallocate(to_fd(m_impl), FALLOC_FL_KEEP_SIZE, m_preallocPos, step) == 0)
+    {
+        m_preallocEnd = m_preallocPos + step;
+        return;
+    }
+#endif
+    // out of space: keep the space reserved so far until the file is closed, but don't try again
+    m_preallocEnd = INT64_MAX;
+}
 
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include <io.h>
 #include <windows.h>
 
+#include <cstring>
+
 #include "../directory.h"
 #include "../file.h"
 
@@ -90,6 +92,18 @@ bool File::open(const char* fName, const unsigned int oflag, unsigned int system
     m_name = fName;
     m_pos = 0;
 
+    if (oflag == ofRead && strcmp(fName, STDIN_FILE_NAME) == 0)
+    {
+        // a copy of the handle, so closing the file keeps the standard input open
+        if (!DuplicateHandle(GetCurrentProcess(), GetStdHandle(STD_INPUT_HANDLE), GetCurrentProcess(), &m_impl, 0,
+                             FALSE, DUPLICATE_SAME_ACCESS))
+        {
+            m_impl = INVALID_HANDLE_VALUE;
+            return false;
+        }
+        return true;
+    }
+
     DWORD dwDesiredAccess = 0;
     DWORD dwCreationDisposition = CREATE_ALWAYS;
     DWORD dwShareMode = 0;
@@ -165,8 +179,42 @@ int File::write(const void* buffer, const uint32_t count)
     return static_cast<int>(bytesWritten);
 }
 
+int64_t File::writev(const IoSlice* slices, const int count) { return AbstractOutputStream::writev(slices, count); }
+
 void File::sync() { FlushFileBuffers(m_impl); }
 
+void File::setWriteback(uint32_t) {}
+
+void File::preallocate(int64_t) {}
+
+bool isPipeInput(const char* fName)
+{
+    if (strcmp(fName, STDIN_FILE_NAME) == 0)
+        return GetFileType(GetStdHandle(STD_INPUT_HANDLE)) != FILE_TYPE_DISK;
+    return strncmp(fName, R"(\\.\pipe\)", 9) == 0;
+}
+
+bool StdoutStream::open(const char*, const unsigned int oflag, unsigned int)
+{
+    return m_written == 0 || (oflag & ofAppend);
+}
+
+int StdoutStream::write(const void* buffer, const uint32_t count)
+{
+    auto data = static_cast<const uint8_t*>(buffer);
+    uint32_t rest = count;
+    while (rest > 0)
+    {
+        DWORD bytesWritten = 0;
+        if (!WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), data, rest, &bytesWritten, nullptr) || bytesWritten == 0)
+            return rest == count ? -1 : static_cast<int>(count - rest);
+        data += bytesWritten;
+        rest -= bytesWritten;
+    }
+    m_written += count;
+    return static_cast<int>(count);
+}
+
 bool File::isOpen() const { return m_impl != INVALID_HANDLE_VALUE; }
 
 bool File::size(int64_t* const fileSize) const
@@ -0,0 +1,158 @@
+#include <bufferedFileReader.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "testCommon.h"
+
+using namespace std;
+
+// Reads a file through BufferedFileReader with the blocking and with the asynchronous (io_uring) read path: the
+// deferred seeks, a seek which fails and the shutdown of the reader thread. The file is made of 32 bit words, each
+// holding its own offset, so every block tells where it was read from.
+
+static constexpr uint32_t BLOCK_SIZE = 64 * 1024;
+static constexpr uint32_t FILE_BLOCKS = 16;
+static const char* const FILE_NAME = "bufferedReaderTest.dat";
+
+static void writeTestFile()
+{
+    std::vector<uint32_t> words(BLOCK_SIZE * FILE_BLOCKS / sizeof(uint32_t));
+    for (size_t i = 0; i < words.size(); ++i) words[i] = static_cast<uint32_t>(i * sizeof(uint32_t));
+    std::ofstream file(FILE_NAME, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(words.data()), static_cast<std::streamsize>(words.size() * 4));
+}
+
+// the offset the block was read from, or -1 if the reader returned no data
+static int64_t blockOffset(const uint8_t* data, const uint32_t readCnt)
+{
+    if (data == nullptr || readCnt < sizeof(uint32_t))
+        return -1;
+    return *reinterpret_cast<const uint32_t*>(data);
+}
+
+static std::unique_ptr<BufferedFileReader> createReader(const uint32_t queueDepth)
+{
+    auto reader = std::make_unique<BufferedFileReader>(BLOCK_SIZE);
+    reader->setQueueDepth(queueDepth);
+    return reader;
+}
+
+template <uint32_t queueDepth>
+static void testSequentialRead()
+{
+    auto reader = createReader(queueDepth);
+    const int readerID = reader->createReader();
+    TEST_CHECK(reader->openStream(readerID, FILE_NAME));
+    uint32_t readCnt = 0;
+    int rez = 0;
+    for (uint32_t block = 0; block < FILE_BLOCKS; ++block)
+    {
+        const uint8_t* data = reader->readBlock(readerID, readCnt, rez);
+        TEST_CHECK(rez == 0);
+        TEST_CHECK(readCnt == BLOCK_SIZE);
+        TEST_CHECK(blockOffset(data, readCnt) == static_cast<int64_t>(block) * BLOCK_SIZE);
+        reader->notify(readerID, readCnt);
+    }
+    reader->readBlock(readerID, readCnt, rez);
+    TEST_CHECK(rez == AbstractReader::DATA_EOF);
+    TEST_CHECK(readCnt == 0);
+    reader->deleteReader(readerID);
+}
+
+template <uint32_t queueDepth>
+static void testIncSeek()
+{
+    auto reader = createReader(queueDepth);
+    const int readerID = reader->createReader();
+    TEST_CHECK(reader->openStream(readerID, FILE_NAME));
+    uint32_t readCnt = 0;
+    int rez = 0;
+    const uint8_t* data = reader->readBlock(readerID, readCnt, rez);
+    TEST_CHECK(blockOffset(data, readCnt) == 0);
+    // the seek is run by the reader thread before the next read, from the end of the data read so far
+    TEST_CHECK(reader->incSeek(readerID, 3 * BLOCK_SIZE + 1024));
+    data = reader->readBlock(readerID, readCnt, rez);
+    TEST_CHECK(rez == 0);
+    TEST_CHECK(blockOffset(data, readCnt) == 4 * BLOCK_SIZE + 1024);
+    // the relative seeks requested before the next read add up
+    TEST_CHECK(reader->incSeek(readerID, BLOCK_SIZE));
+    TEST_CHECK(reader->incSeek(readerID, -2 * static_cast<int64_t>(BLOCK_SIZE)));
+    data = reader->readBlock(readerID, readCnt, rez);
+    TEST_CHECK(blockOffset(data, readCnt) == 4 * BLOCK_SIZE + 1024);
+    // the blocks read ahead before a seek are dropped
+    reader->notify(readerID, readCnt);
+    TEST_CHECK(reader->gotoByte(readerID, 8 * BLOCK_SIZE));
+    data = reader->readBlock(readerID, readCnt, rez);
+    TEST_CHECK(blockOffset(data, readCnt) == 8 * BLOCK_SIZE);
+    reader->deleteReader(readerID);
+}
+
+template <uint32_t queueDepth>
+static void testFailedSeek()
+{
+    auto reader = createReader(queueDepth);
+    const int readerID = reader->createReader();
+    TEST_CHECK(reader->openStream(readerID, FILE_NAME));
+    uint32_t readCnt = 0;
+    int rez = 0;
+    const uint8_t* data = reader->readBlock(readerID, readCnt, rez);
+    TEST_CHECK(blockOffset(data, readCnt) == 0);
+    // the request is only queued, the failure is reported by the next read as the end of the stream
+    TEST_CHECK(reader->incSeek(readerID, -4 * static_cast<int64_t>(BLOCK_SIZE)));
+    reader->readBlock(readerID, readCnt, rez);
+    TEST_CHECK(rez == AbstractReader::DATA_EOF);
+    TEST_CHECK(readCnt == 0);
+    reader->readBlock(readerID, readCnt, rez);
+    TEST_CHECK(rez == AbstractReader::DATA_EOF);
+    TEST_CHECK(readCnt == 0);
+    // a later seek makes the stream readable again
+    TEST_CHECK(reader->gotoByte(readerID, 2 * BLOCK_SIZE));
+    data = reader->readBlock(readerID, readCnt, rez);
+    TEST_CHECK(rez == 0);
+    TEST_CHECK(blockOffset(data, readCnt) == 2 * BLOCK_SIZE);
+    reader->deleteReader(readerID);
+}
+
+template <uint32_t queueDepth>
+static void testShutdown()
+{
+    // a reader which never started its thread
+    createReader(queueDepth).reset();
+
+    // the destructor stops the thread while reads are queued and the stream is still open
+    auto reader = createReader(queueDepth);
+    const int readerID = reader->createReader();
+    TEST_CHECK(reader->openStream(readerID, FILE_NAME));
+    uint32_t readCnt = 0;
+    int rez = 0;
+    reader->readBlock(readerID, readCnt, rez);
+    reader->notify(readerID, readCnt);
+    reader.reset();
+
+    // and after the stream is deleted, with nothing left to read
+    reader = createReader(queueDepth);
+    const int secondID = reader->createReader();
+    TEST_CHECK(reader->openStream(secondID, FILE_NAME));
+    reader->readBlock(secondID, readCnt, rez);
+    reader->deleteReader(secondID);
+    reader.reset();
+}
+
+int main()
+{
+    writeTestFile();
+    TEST_RUN(testSequentialRead<0>);
+    TEST_RUN(testSequentialRead<8>);
+    TEST_RUN(testIncSeek<0>);
+    TEST_RUN(testIncSeek<8>);
+    TEST_RUN(testFailedSeek<0>);
+    TEST_RUN(testFailedSeek<8>);
+    TEST_RUN(testShutdown<0>);
+    TEST_RUN(testShutdown<8>);
+    std::remove(FILE_NAME);
+    return testResult();
+}
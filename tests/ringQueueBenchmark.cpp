@@ -0,0 +1,95 @@
+#include <containers/ringqueue.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Contention microbenchmark of the ring queues: several producers push into one queue drained by one consumer, as
+// the demuxers do with the read queue of BufferedReader. A queue guarded by a mutex and a condition variable is
+// measured for comparison. Usage: ringQueueBenchmark [values per producer]
+
+// the queue the ring queues have replaced
+template <typename T>
+class LockedQueue
+{
+   public:
+    explicit LockedQueue(const size_t capacity) : m_capacity(capacity) {}
+
+    void push(const T& val)
+    {
+        std::unique_lock lk(m_mtx);
+        while (m_queue.size() >= m_capacity) m_notFull.wait(lk);
+        m_queue.push(val);
+        m_notEmpty.notify_one();
+    }
+
+    T pop()
+    {
+        std::unique_lock lk(m_mtx);
+        while (m_queue.empty()) m_notEmpty.wait(lk);
+        T val = m_queue.front();
+        m_queue.pop();
+        m_notFull.notify_all();
+        return val;
+    }
+
+   private:
+    const size_t m_capacity;
+    std::queue<T> m_queue;
+    std::mutex m_mtx;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+};
+
+template <typename Queue>
+static double run(const int producers, const int count, const size_t capacity)
+{
+    Queue queue(capacity);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+        threads.emplace_back([&queue, count] {
+            for (int i = 1; i <= count; ++i) queue.push(i);
+        });
+    int64_t sum = 0;
+    for (int64_t i = 0; i < static_cast<int64_t>(producers) * count; ++i) sum += queue.pop();
+    for (auto& thread : threads) thread.join();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (sum != static_cast<int64_t>(producers) * count * (count + 1) / 2)
+    {
+        std::cerr << "lost values" << std::endl;
+        std::exit(1);
+    }
+    return static_cast<double>(producers) * count / elapsed.count() / 1e6;
+}
+
+int main(const int argc, char** argv)
+{
+    const int count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << ", values per producer: " << count
+              << std::endl;
+    std::cout << "producers capacity    MpscQueue  LockedQueue  (millions of values per second)" << std::endl;
+    for (const size_t capacity : {16, 4096})
+        for (const int producers : {1, 2, 4, 8})
+        {
+            const double ring = run<MpscQueue<int>>(producers, count, capacity);
+            const double locked = run<LockedQueue<int>>(producers, count, capacity);
+            std::cout.width(9);
+            std::cout << producers << " ";
+            std::cout.width(8);
+            std::cout << capacity << " ";
+            std::cout.width(12);
+            std::cout << ring << " ";
+            std::cout.width(12);
+            std::cout << locked << std::endl;
+        }
+    std::cout << "SpscQueue, one producer: " << run<SpscQueue<int>>(1, count, 4096) << std::endl;
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <containers/ringqueue.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "testCommon.h"
+
+using namespace std;
+
+static constexpr auto BLOCK_CHECK_TIME = std::chrono::milliseconds(50);
+
+static void testCapacity()
+{
+    TEST_CHECK(SpscQueue<int>(1).capacity() == 1);
+    TEST_CHECK(SpscQueue<int>(5).capacity() == 8);
+    TEST_CHECK(MpscQueue<int>(16).capacity() == 16);
+    TEST_CHECK(MpscQueue<int>(17).capacity() == 32);
+}
+
+template <typename Queue>
+static void testWraparound()
+{
+    Queue queue(4);
+    int pushed = 0;
+    int popped = 0;
+    // three elements per round, so the positions go round the buffer at every offset
+    for (int round = 0; round < 1000; ++round)
+    {
+        for (int i = 0; i < 3; ++i) TEST_CHECK(queue.tryPush(pushed++));
+        TEST_CHECK(queue.size() == 3);
+        TEST_CHECK(queue.front() != nullptr && *queue.front() == popped);
+        for (int i = 0; i < 3; ++i)
+        {
+            int val = -1;
+            TEST_CHECK(queue.tryPop(val));
+            TEST_CHECK(val == popped++);
+        }
+        TEST_CHECK(queue.empty());
+    }
+}
+
+template <typename Queue>
+static void testFullAndEmpty()
+{
+    Queue queue(4);
+    int val = -1;
+    TEST_CHECK(queue.empty());
+    TEST_CHECK(queue.front() == nullptr);
+    TEST_CHECK(!queue.tryPop(val));
+    for (int i = 0; i < 4; ++i) TEST_CHECK(queue.tryPush(i));
+    TEST_CHECK(queue.full());
+    TEST_CHECK(!queue.tryPush(4));
+    TEST_CHECK(queue.tryPop(val) && val == 0);
+    TEST_CHECK(!queue.full());
+    TEST_CHECK(queue.tryPush(4));
+    for (int i = 1; i <= 4; ++i) TEST_CHECK(queue.pop() == i);
+    TEST_CHECK(queue.empty());
+}
+
+template <typename Queue>
+static void testPushBlocksWhileFull()
+{
+    Queue queue(2);
+    queue.push(1);
+    queue.push(2);
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        queue.push(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(BLOCK_CHECK_TIME);
+    TEST_CHECK(!pushed);
+    TEST_CHECK(queue.pop() == 1);
+    producer.join();
+    TEST_CHECK(pushed);
+    TEST_CHECK(queue.pop() == 2);
+    TEST_CHECK(queue.pop() == 3);
+}
+
+template <typename Queue>
+static void testPopBlocksWhileEmpty()
+{
+    Queue queue(2);
+    std::atomic<int> popped{-1};
+    std::thread consumer([&] { popped = queue.pop(); });
+    std::this_thread::sleep_for(BLOCK_CHECK_TIME);
+    TEST_CHECK(popped == -1);
+    queue.push(7);
+    consumer.join();
+    TEST_CHECK(popped == 7);
+}
+
+template <typename Queue>
+static void testOneProducer()
+{
+    constexpr int count = 200000;
+    Queue queue(64);
+    std::thread producer([&] {
+        for (int i = 0; i < count; ++i) queue.push(i);
+    });
+    int expected = 0;
+    for (int i = 0; i < count; ++i)
+        if (queue.pop() == expected)
+            ++expected;
+    producer.join();
+    TEST_CHECK(expected == count);
+    TEST_CHECK(queue.empty());
+}
+
+static void testManyProducers()
+{
+    constexpr int producers = 4;
+    constexpr int count = 50000;
+    // a small queue, so the producers contend for the slots and wait while it is full
+    MpscQueue<int> queue(16);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < count; ++i) queue.push(p * count + i);
+        });
+    // the values of each producer arrive in its order and none is lost or duplicated
+    std::vector<int> next(producers, 0);
+    bool ordered = true;
+    for (int i = 0; i < producers * count; ++i)
+    {
+        const int val = queue.pop();
+        const int p = val / count;
+        if (p < 0 || p >= producers || val % count != next[p])
+            ordered = false;
+        else
+            ++next[p];
+    }
+    for (auto& thread : threads) thread.join();
+    TEST_CHECK(ordered);
+    for (int p = 0; p < producers; ++p) TEST_CHECK(next[p] == count);
+    TEST_CHECK(queue.empty());
+    int val;
+    TEST_CHECK(!queue.tryPop(val));
+}
+
+int main()
+{
+    TEST_RUN(testCapacity);
+    TEST_RUN(testWraparound<SpscQueue<int>>);
+    TEST_RUN(testWraparound<MpscQueue<int>>);
+    TEST_RUN(testFullAndEmpty<SpscQueue<int>>);
+    TEST_RUN(testFullAndEmpty<MpscQueue<int>>);
+    TEST_RUN(testPushBlocksWhileFull<SpscQueue<int>>);
+    TEST_RUN(testPushBlocksWhileFull<MpscQueue<int>>);
+    TEST_RUN(testPopBlocksWhileEmpty<SpscQueue<int>>);
+    TEST_RUN(testPopBlocksWhileEmpty<MpscQueue<int>>);
+    TEST_RUN(testOneProducer<SpscQueue<int>>);
+    TEST_RUN(testOneProducer<MpscQueue<int>>);
+    TEST_RUN(testManyProducers);
+    return testResult();
+}
@@ -0,0 +1,509 @@
+#include <bufferedReaderManager.h>
+#include <matroskaDemuxer.h>
+#include <movDemuxer.h>
+#include <tsDemuxer.h>
+#include <tsPacket.h>
+#include <vod_common.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "testCommon.h"
+
+using namespace std;
+
+// seekToTime() of the MKV, MP4 and TS demuxers on files built by the test: 300 frames of 40 ms with a key frame every
+// second. Each frame starts with its number, so the demuxed data tells which frame a track starts from.
+
+static constexpr int FRAME_COUNT = 300;
+static constexpr int FRAME_MS = 40;
+static constexpr int GOP_SIZE = 25;
+
+// the time of the key frame the tracks must start from when seeking to 5.5 s
+static constexpr int64_t SEEK_TIME = INTERNAL_PTS_FREQ * 11 / 2;
+static constexpr int SEEK_FRAME = 125;
+static constexpr int64_t SEEK_FRAME_TIME = INTERNAL_PTS_FREQ * SEEK_FRAME * FRAME_MS / 1000;
+
+static BufferedReaderManager readManager(2, DEFAULT_FILE_BLOCK_SIZE, DEFAULT_FILE_BLOCK_SIZE + MAX_AV_PACKET_SIZE,
+                                         DEFAULT_FILE_BLOCK_SIZE / 2);
+
+typedef std::vector<uint8_t> Bytes;
+
+static void putBE(Bytes& dst, const uint64_t value, const int size)
+{
+    for (int i = size - 1; i >= 0; --i) dst.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+static void putStr(Bytes& dst, const std::string& str) { dst.insert(dst.end(), str.begin(), str.end()); }
+
+static void append(Bytes& dst, const Bytes& src) { dst.insert(dst.end(), src.begin(), src.end()); }
+
+static uint32_t getBE32(const uint8_t* data) { return data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3]; }
+
+// the payload of the frame: its number and a filler without start codes
+static Bytes frameData(const int frame)
+{
+    Bytes data;
+    putBE(data, frame, 4);
+    data.resize(200 + frame % 7 * 16, static_cast<uint8_t>(0x10 + frame % 0x40));
+    return data;
+}
+
+static void writeFile(const char* fileName, const Bytes& data)
+{
+    std::ofstream file(fileName, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+// demux the track up to the end of the file
+static MemoryBlock demuxTrack(AbstractDemuxer& demuxer, const int pid)
+{
+    MemoryBlock rez;
+    const PIDSet pids{pid};
+    for (int i = 0; i < 10000; ++i)
+    {
+        DemuxedData demuxedData;
+        int64_t discardSize = 0;
+        const int readRez = demuxer.simpleDemuxBlock(demuxedData, pids, discardSize);
+        rez.append(demuxedData[pid].data(), demuxedData[pid].size());
+        if (readRez == BufferedReader::DATA_EOF)
+            break;
+    }
+    return rez;
+}
+
+// the frames in the data of an MKV or MP4 track, which holds the payloads one after another
+static std::vector<int> framesOf(MemoryBlock& data)
+{
+    std::vector<int> frames;
+    for (size_t pos = 0; pos + 4 <= data.size();)
+    {
+        const auto frame = static_cast<int>(getBE32(data.data() + pos));
+        frames.push_back(frame);
+        if (frame < 0 || frame >= FRAME_COUNT)
+            break;
+        pos += frameData(frame).size();
+    }
+    return frames;
+}
+
+static bool framesFrom(MemoryBlock& data, const int firstFrame)
+{
+    const std::vector<int> frames = framesOf(data);
+    if (frames.size() != static_cast<size_t>(FRAME_COUNT - firstFrame))
+        return false;
+    for (size_t i = 0; i < frames.size(); ++i)
+        if (frames[i] != firstFrame + static_cast<int>(i))
+            return false;
+    return true;
+}
+
+// ------------------------------------------------------------------ MKV
+
+// an EBML element, its size is always stored in 8 bytes so the positions are easy to compute
+static Bytes ebml(const uint32_t id, const Bytes& data)
+{
+    Bytes rez;
+    putBE(rez, id, id > 0xffffff ? 4 : id > 0xffff ? 3 : id > 0xff ? 2 : 1);
+    putBE(rez, 0x0100000000000000ULL | data.size(), 8);
+    append(rez, data);
+    return rez;
+}
+
+static Bytes ebmlUint(const uint32_t id, const uint64_t value)
+{
+    Bytes data;
+    putBE(data, value, 8);
+    return ebml(id, data);
+}
+
+static Bytes ebmlStr(const uint32_t id, const std::string& str)
+{
+    Bytes data;
+    putStr(data, str);
+    return ebml(id, data);
+}
+
+// a cluster per second, the cues follow the clusters and are found through the seek head
+static Bytes buildMkv()
+{
+    Bytes header;
+    append(header, ebmlUint(0x4286, 1));  // EBMLVersion
+    append(header, ebmlUint(0x42F7, 1));  // EBMLReadVersion
+    append(header, ebmlUint(0x42F2, 4));  // EBMLMaxIDLength
+    append(header, ebmlUint(0x42F3, 8));  // EBMLMaxSizeLength
+    append(header, ebmlStr(0x4282, "matroska"));
+    append(header, ebmlUint(0x4287, 4));  // DocTypeVersion
+    append(header, ebmlUint(0x4285, 2));  // DocTypeReadVersion
+
+    Bytes info = ebmlUint(0x2AD7B1, 1000000);  // TimecodeScale, 1 ms
+    append(info, ebmlStr(0x4D80, "seekTest"));
+    append(info, ebmlStr(0x5741, "seekTest"));
+    info = ebml(0x1549A966, info);
+
+    Bytes video = ebmlUint(0xB0, 320);
+    append(video, ebmlUint(0xBA, 240));
+    Bytes track = ebmlUint(0xD7, 1);  // TrackNumber
+    append(track, ebmlUint(0x73C5, 1));  // TrackUID
+    append(track, ebmlUint(0x83, 1));  // TrackType, video
+    append(track, ebmlStr(0x86, "V_MPEG2"));
+    append(track, ebmlUint(0x23E383, FRAME_MS * 1000000));  // DefaultDuration
+    append(track, ebml(0xE0, video));
+    const Bytes tracks = ebml(0x1654AE6B, ebml(0xAE, track));
+
+    std::vector<Bytes> clusters;
+    for (int gop = 0; gop < FRAME_COUNT; gop += GOP_SIZE)
+    {
+        Bytes cluster = ebmlUint(0xE7, gop * FRAME_MS);  // Timecode
+        for (int frame = gop; frame < gop + GOP_SIZE; ++frame)
+        {
+            Bytes block{0x81};  // track 1
+            putBE(block, (frame - gop) * FRAME_MS, 2);
+            block.push_back(frame == gop ? 0x80 : 0);  // key frame flag
+            append(block, frameData(frame));
+            append(cluster, ebml(0xA3, block));  // SimpleBlock
+        }
+        clusters.push_back(ebml(0x1F43B675, cluster));
+    }
+
+    // the positions are relative to the start of the segment data
+    const auto seekEntry = [](const uint32_t id, const uint64_t pos)
+    {
+        Bytes seekId;
+        putBE(seekId, id, 4);
+        Bytes entry = ebml(0x53AB, seekId);
+        append(entry, ebmlUint(0x53AC, pos));
+        return ebml(0x4DBB, entry);
+    };
+    const size_t seekHeadSize = ebml(0x114D9B74, seekEntry(0x1C53BB6B, 0)).size();
+    uint64_t pos = seekHeadSize + info.size() + tracks.size();
+    Bytes cues;
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        Bytes positions = ebmlUint(0xF7, 1);  // CueTrack
+        append(positions, ebmlUint(0xF1, pos));  // CueClusterPosition
+        Bytes cuePoint = ebmlUint(0xB3, i * GOP_SIZE * FRAME_MS);  // CueTime
+        append(cuePoint, ebml(0xB7, positions));
+        append(cues, ebml(0xBB, cuePoint));
+        pos += clusters[i].size();
+    }
+
+    Bytes segment = ebml(0x114D9B74, seekEntry(0x1C53BB6B, pos));
+    append(segment, info);
+    append(segment, tracks);
+    for (const Bytes& cluster : clusters) append(segment, cluster);
+    append(segment, ebml(0x1C53BB6B, cues));
+
+    Bytes file = ebml(0x1A45DFA3, header);
+    append(file, ebml(0x18538067, segment));
+    return file;
+}
+
+static void testMkvSeek()
+{
+    const char* fileName = "seekTest.mkv";
+    writeFile(fileName, buildMkv());
+    {
+        MatroskaDemuxer demuxer(readManager, fileName);
+        demuxer.openFile(fileName);
+        std::map<int32_t, int64_t> times{{1, SEEK_TIME}};
+        TEST_CHECK(demuxer.seekToTime(times));
+        TEST_CHECK(times[1] == SEEK_FRAME_TIME);
+        MemoryBlock data = demuxTrack(demuxer, 1);
+        TEST_CHECK(framesFrom(data, SEEK_FRAME));
+    }
+    {
+        // the first cluster is read anyway, there is nothing to skip
+        MatroskaDemuxer demuxer(readManager, fileName);
+        demuxer.openFile(fileName);
+        std::map<int32_t, int64_t> times{{1, INTERNAL_PTS_FREQ / 2}};
+        TEST_CHECK(!demuxer.seekToTime(times));
+        MemoryBlock data = demuxTrack(demuxer, 1);
+        TEST_CHECK(framesFrom(data, 0));
+    }
+    std::remove(fileName);
+}
+
+// ------------------------------------------------------------------ MP4
+
+static Bytes box(const char* type, const Bytes& data)
+{
+    Bytes rez;
+    putBE(rez, data.size() + 8, 4);
+    putStr(rez, type);
+    append(rez, data);
+    return rez;
+}
+
+static Bytes fullBox(const char* type, const uint32_t flags, const Bytes& data)
+{
+    Bytes payload;
+    putBE(payload, flags, 4);  // version 0
+    append(payload, data);
+    return box(type, payload);
+}
+
+static void putMatrix(Bytes& dst)
+{
+    for (const uint32_t value : {0x10000, 0, 0, 0, 0x10000, 0, 0, 0, 0x40000000}) putBE(dst, value, 4);
+}
+
+// a track of an unknown format is demuxed as is. A chunk holds 10 frames, so the key frames are inside the chunks
+static Bytes buildMp4()
+{
+    constexpr int chunkFrames = 10;
+    constexpr uint32_t timeScale = 1000;
+    const Bytes ftyp = box("ftyp", {'i', 's', 'o', 'm', 0, 0, 2, 0, 'i', 's', 'o', 'm'});
+
+    const auto buildMoov = [&](const uint64_t mdatPos)
+    {
+        Bytes stsdEntry;
+        putBE(stsdEntry, 16, 4);
+        putStr(stsdEntry, "tst ");
+        putBE(stsdEntry, 1, 8);  // reserved, data reference index
+        Bytes stsd;
+        putBE(stsd, 1, 4);
+        append(stsd, stsdEntry);
+
+        Bytes stts;
+        putBE(stts, 1, 4);
+        putBE(stts, FRAME_COUNT, 4);
+        putBE(stts, FRAME_MS * timeScale / 1000, 4);
+
+        Bytes stss;
+        putBE(stss, FRAME_COUNT / GOP_SIZE, 4);
+        for (int frame = 0; frame < FRAME_COUNT; frame += GOP_SIZE) putBE(stss, frame + 1, 4);
+
+        Bytes stsc;
+        putBE(stsc, 1, 4);
+        putBE(stsc, 1, 4);  // first chunk
+        putBE(stsc, chunkFrames, 4);
+        putBE(stsc, 1, 4);  // sample description index
+
+        Bytes stsz;
+        putBE(stsz, 0, 4);
+        putBE(stsz, FRAME_COUNT, 4);
+        for (int frame = 0; frame < FRAME_COUNT; ++frame) putBE(stsz, frameData(frame).size(), 4);
+
+        Bytes stco;
+        putBE(stco, FRAME_COUNT / chunkFrames, 4);
+        uint64_t pos = mdatPos + 8;
+        for (int frame = 0; frame < FRAME_COUNT; ++frame)
+        {
+            if (frame % chunkFrames == 0)
+                putBE(stco, pos, 4);
+            pos += frameData(frame).size();
+        }
+
+        Bytes stbl = fullBox("stsd", 0, stsd);
+        append(stbl, fullBox("stts", 0, stts));
+        append(stbl, fullBox("stss", 0, stss));
+        append(stbl, fullBox("stsc", 0, stsc));
+        append(stbl, fullBox("stsz", 0, stsz));
+        append(stbl, fullBox("stco", 0, stco));
+
+        const uint32_t duration = FRAME_COUNT * FRAME_MS * timeScale / 1000;
+        Bytes mdhd;
+        putBE(mdhd, 0, 8);  // creation and modification time
+        putBE(mdhd, timeScale, 4);
+        putBE(mdhd, duration, 4);
+        putBE(mdhd, 0x55c4, 2);  // language: und
+        putBE(mdhd, 0, 2);
+        Bytes hdlr;
+        putBE(hdlr, 0, 4);
+        putStr(hdlr, "vide");
+        putBE(hdlr, 0, 12);
+        putStr(hdlr, "test");
+        hdlr.push_back(0);
+        Bytes mdia = fullBox("mdhd", 0, mdhd);
+        append(mdia, fullBox("hdlr", 0, hdlr));
+        append(mdia, box("minf", box("stbl", stbl)));
+
+        Bytes tkhd;
+        putBE(tkhd, 0, 8);  // creation and modification time
+        putBE(tkhd, 1, 4);  // track id
+        putBE(tkhd, 0, 4);
+        putBE(tkhd, duration, 4);
+        putBE(tkhd, 0, 16);  // reserved, layer, alternate group, volume, reserved
+        putMatrix(tkhd);
+        putBE(tkhd, 320 << 16, 4);
+        putBE(tkhd, 240 << 16, 4);
+        Bytes trak = fullBox("tkhd", 3, tkhd);
+        append(trak, box("mdia", mdia));
+
+        Bytes mvhd;
+        putBE(mvhd, 0, 8);  // creation and modification time
+        putBE(mvhd, timeScale, 4);
+        putBE(mvhd, duration, 4);
+        putBE(mvhd, 0x10000, 4);  // rate
+        putBE(mvhd, 0x100, 2);    // volume
+        putBE(mvhd, 0, 10);
+        putMatrix(mvhd);
+        putBE(mvhd, 0, 24);
+        putBE(mvhd, 2, 4);  // next track id
+        Bytes moov = fullBox("mvhd", 0, mvhd);
+        append(moov, box("trak", trak));
+        return box("moov", moov);
+    };
+
+    Bytes mdat;
+    for (int frame = 0; frame < FRAME_COUNT; ++frame) append(mdat, frameData(frame));
+    Bytes file = ftyp;
+    append(file, buildMoov(ftyp.size() + buildMoov(0).size()));
+    append(file, box("mdat", mdat));
+    return file;
+}
+
+static void testMp4Seek()
+{
+    const char* fileName = "seekTest.mp4";
+    writeFile(fileName, buildMp4());
+    {
+        // the key frame is the 6th frame of its chunk, the frames before it are skipped
+        MovDemuxer demuxer(readManager, fileName);
+        demuxer.openFile(fileName);
+        std::map<int32_t, int64_t> times{{1, SEEK_TIME}};
+        TEST_CHECK(demuxer.seekToTime(times));
+        TEST_CHECK(times[1] == SEEK_FRAME_TIME);
+        MemoryBlock data = demuxTrack(demuxer, 1);
+        TEST_CHECK(framesFrom(data, SEEK_FRAME));
+    }
+    {
+        MovDemuxer demuxer(readManager, fileName);
+        demuxer.openFile(fileName);
+        std::map<int32_t, int64_t> times{{1, INTERNAL_PTS_FREQ / 2}};
+        TEST_CHECK(!demuxer.seekToTime(times));
+        MemoryBlock data = demuxTrack(demuxer, 1);
+        TEST_CHECK(framesFrom(data, 0));
+    }
+    std::remove(fileName);
+}
+
+// ------------------------------------------------------------------ TS
+
+static constexpr int VIDEO_PID = 0x1011;
+static constexpr int64_t FIRST_PTS = 90000 * 10;
+// each frame takes at least this many TS packets, so the file is large enough for the PCR search to seek. The sizes
+// differ, so the search lands inside a group of pictures
+static constexpr int FRAME_PACKETS = 40;
+
+static void putTimestamp(Bytes& dst, const int prefix, const int64_t value)
+{
+    dst.push_back(static_cast<uint8_t>(prefix << 4 | (value >> 29 & 0x0e) | 1));
+    dst.push_back(static_cast<uint8_t>(value >> 22));
+    dst.push_back(static_cast<uint8_t>(value >> 14 | 1));
+    dst.push_back(static_cast<uint8_t>(value >> 7));
+    dst.push_back(static_cast<uint8_t>(value << 1 | 1));
+}
+
+static Bytes tsHeader(const int pid, const bool payloadStart, const int counter, const bool adaptationField)
+{
+    return {TSPacket::TS_FRAME_SYNC_BYTE, static_cast<uint8_t>((payloadStart ? 0x40 : 0) | pid >> 8),
+            static_cast<uint8_t>(pid), static_cast<uint8_t>((adaptationField ? 0x30 : 0x10) | (counter & 0x0f))};
+}
+
+// the H.264 access unit of the frame: a key frame has the parameter sets and an IDR slice
+static Bytes videoFrame(const int frame)
+{
+    Bytes es{0, 0, 0, 1, 9, 0x10};  // access unit delimiter
+    if (frame % GOP_SIZE == 0)
+        append(es, {0, 0, 0, 1, 0x67, 0x42, 0, 0x1e, 0xab,  // SPS
+                    0, 0, 0, 1, 0x68, 0xce, 0x38, 0x80,     // PPS
+                    0, 0, 0, 1, 0x65, 0x88});               // IDR slice
+    else
+        append(es, {0, 0, 0, 1, 0x41, 0x9a});
+    append(es, frameData(frame));
+    return es;
+}
+
+// a PES packet per frame, the first TS packet of a key frame has the random access flag
+static Bytes buildTs()
+{
+    Bytes file;
+    Bytes psi(TS_FRAME_SIZE * 2, 0xff);
+    TS_program_association_section pat;
+    pat.pmtPids[DEFAULT_PMT_PID] = 1;
+    const Bytes patHeader = tsHeader(0, true, 0, false);
+    std::copy(patHeader.begin(), patHeader.end(), psi.begin());
+    pat.serialize(psi.data() + TSPacket::TS_HEADER_SIZE, TS_FRAME_SIZE - TSPacket::TS_HEADER_SIZE);
+    TS_program_map_section pmt;
+    pmt.program_number = 1;
+    pmt.pcr_pid = VIDEO_PID;
+    pmt.video_pid = VIDEO_PID;
+    pmt.video_type = static_cast<int>(StreamType::VIDEO_H264);
+    const Bytes pmtHeader = tsHeader(DEFAULT_PMT_PID, true, 0, false);
+    std::copy(pmtHeader.begin(), pmtHeader.end(), psi.begin() + TS_FRAME_SIZE);
+    pmt.serialize(psi.data() + TS_FRAME_SIZE + TSPacket::TS_HEADER_SIZE, TS_FRAME_SIZE - TSPacket::TS_HEADER_SIZE,
+                  false, false);
+
+    int counter = 0;
+    for (int frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        const bool keyFrame = frame % GOP_SIZE == 0;
+        if (keyFrame)
+            append(file, psi);
+        const int64_t pts = FIRST_PTS + frame * FRAME_MS * 90;
+        const Bytes es = videoFrame(frame);
+
+        Bytes packet = tsHeader(VIDEO_PID, true, counter++, true);
+        packet.push_back(7);                        // adaptation field length
+        packet.push_back(keyFrame ? 0x50 : 0x10);  // random access indicator, PCR
+        const int64_t pcr = pts - 9000;
+        putBE(packet, pcr >> 1, 4);
+        packet.push_back(static_cast<uint8_t>((pcr & 1) << 7 | 0x7e));
+        packet.push_back(0);
+        append(packet, {0, 0, 1, PES_VIDEO_ID, 0, 0, 0x80, 0xc0, 10});
+        putTimestamp(packet, 3, pts);
+        putTimestamp(packet, 1, pts);
+        size_t esPos = 0;
+        for (int i = 0; i < FRAME_PACKETS + frame % 11; ++i)
+        {
+            if (i > 0)
+                packet = tsHeader(VIDEO_PID, false, counter++, false);
+            const size_t size = std::min(TS_FRAME_SIZE - packet.size(), es.size() - esPos);
+            packet.insert(packet.end(), es.begin() + esPos, es.begin() + esPos + size);
+            esPos += size;
+            packet.resize(TS_FRAME_SIZE, 0x11);  // the rest of the frame is filler
+            append(file, packet);
+        }
+    }
+    return file;
+}
+
+static void testTsSeek()
+{
+    const char* fileName = "seekTest.ts";
+    writeFile(fileName, buildTs());
+    {
+        TSDemuxer demuxer(readManager, fileName);
+        demuxer.openFile(fileName);
+        std::map<int32_t, int64_t> times{{VIDEO_PID, SEEK_TIME}};
+        TEST_CHECK(demuxer.seekToTime(times));
+        // the PCR search may land on any key frame before the time
+        const int64_t keyFrameTime = INTERNAL_PTS_FREQ * GOP_SIZE * FRAME_MS / 1000;
+        TEST_CHECK(times[VIDEO_PID] > 0 && times[VIDEO_PID] <= SEEK_FRAME_TIME);
+        TEST_CHECK(times[VIDEO_PID] % keyFrameTime == 0);
+        // the PES headers are removed, the video data starts with the key frame the time is given for
+        MemoryBlock data = demuxTrack(demuxer, VIDEO_PID);
+        const Bytes keyFrame = videoFrame(static_cast<int>(times[VIDEO_PID] * 1000 / INTERNAL_PTS_FREQ / FRAME_MS));
+        TEST_CHECK(data.size() > keyFrame.size() && std::equal(keyFrame.begin(), keyFrame.end(), data.data()));
+    }
+    {
+        TSDemuxer demuxer(readManager, fileName);
+        demuxer.openFile(fileName);
+        std::map<int32_t, int64_t> times{{VIDEO_PID, INTERNAL_PTS_FREQ / 2}};
+        TEST_CHECK(!demuxer.seekToTime(times));
+    }
+    std::remove(fileName);
+}
+
+int main()
+{
+    TEST_RUN(testMkvSeek);
+    TEST_RUN(testMp4Seek);
+    TEST_RUN(testTsSeek);
+    return testResult();
+}
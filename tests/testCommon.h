@@ -0,0 +1,36 @@
+#ifndef TEST_COMMON_H_
+#define TEST_COMMON_H_
+
+#include <iostream>
+
+// The unit tests are plain executables run by ctest. A failed check is reported and counted, the test fails if
+// main() returns a non zero value
+
+inline int testFailures = 0;
+
+#define TEST_CHECK(cond)                                                                          \
+    do                                                                                            \
+    {                                                                                             \
+        if (!(cond))                                                                              \
+        {                                                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #cond << std::endl; \
+            ++testFailures;                                                                       \
+        }                                                                                         \
+    } while (0)
+
+#define TEST_RUN(test)                                                                           \
+    do                                                                                           \
+    {                                                                                            \
+        const int failuresBefore = testFailures;                                                 \
+        test();                                                                                  \
+        std::cout << (testFailures == failuresBefore ? "ok   " : "FAIL ") << #test << std::endl; \
+    } while (0)
+
+inline int testResult()
+{
+    if (testFailures)
+        std::cerr << testFailures << " check(s) failed" << std::endl;
+    return testFailures ? 1 : 0;
+}
+
+#endif  // TEST_COMMON_H_
@@ -6,9 +6,11 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <types/types.h>
 
+#include "abstractReader.h"
 #include "avPacket.h"
 #include "vod_common.h"
 
@@ -19,15 +21,17 @@ class MemoryBlock
    public:
     MemoryBlock(const MemoryBlock& other)
     {
-        assert(other.m_size == 0);
+        assert(other.size() == 0);
         m_size = 0;
+        m_sliceSize = 0;
     }
 
-    MemoryBlock() : m_size(0) {}
+    MemoryBlock() : m_size(0), m_sliceSize(0) {}
     void reserve(const unsigned num) { m_data.resize(num); }
 
     void resize(const unsigned num)
     {
+        gather();
         m_size = num;
         if (m_data.size() < m_size)
             m_data.resize(m_size);
@@ -35,11 +39,8 @@ class MemoryBlock
 
     void grow(const size_t num)
     {
-        m_size += num;
-        if (m_data.size() < m_size)
-        {
-            m_data.resize(FFMIN(m_size * 2, m_size + 1024LL * 1024));
-        }
+        gather();
+        growData(num);
     }
 
     void append(const uint8_t* data, const size_t num)
@@ -51,17 +52,111 @@ class MemoryBlock
         }
     }
 
-    [[nodiscard]] size_t size() const { return m_size; }
+    //! Append data without copying it
+    /*!
+            The data stays in the buffer of the caller until the block is used as a contiguous buffer (data(),
+            resize(), grow(), append()) or gather() is called, so the buffer must stay valid until then.
+    */
+    void appendRef(const uint8_t* data, const size_t num)
+    {
+        if (num == 0)
+            return;
+        if (!m_slices.empty() && m_slices.back().data + m_slices.back().size == data)
+            m_slices.back().size += static_cast<uint32_t>(num);
+        else
+            m_slices.push_back({data, static_cast<uint32_t>(num)});
+        m_sliceSize += num;
+    }
 
-    uint8_t* data() { return m_data.empty() ? nullptr : m_data.data(); }
+    //! Copy the data appended by appendRef() into the block
+    void gather()
+    {
+        if (m_slices.empty())
+            return;
+        size_t pos = m_size;
+        growData(m_sliceSize);
+        for (const DataSlice& slice : m_slices)
+        {
+            memcpy(&m_data[pos], slice.data, slice.size);
+            pos += slice.size;
+        }
+        m_slices.clear();
+        m_sliceSize = 0;
+    }
 
-    [[nodiscard]] bool isEmpty() const { return m_size == 0; }
+    //! Drop num bytes following the first offset bytes of the block
+    void consume(const size_t offset, size_t num)
+    {
+        assert(m_size >= offset && size() - offset >= num);
+        const size_t stored = m_size - offset;
+        if (num < stored)
+        {
+            memmove(&m_data[offset], &m_data[offset + num], stored - num);
+            m_size -= num;
+            return;
+        }
+        num -= stored;
+        m_size = offset;
+        m_sliceSize -= num;
+        auto slice = m_slices.begin();
+        for (; num > 0 && num >= slice->size; ++slice) num -= slice->size;
+        if (num > 0)
+        {
+            slice->data += num;
+            slice->size -= static_cast<uint32_t>(num);
+        }
+        m_slices.erase(m_slices.begin(), slice);
+    }
 
-    void clear() { m_size = 0; }
+    //! Get up to count bytes following the first offset bytes of the block without gathering them
+    void getSlices(const size_t offset, size_t count, std::vector<DataSlice>& slices) const
+    {
+        slices.clear();
+        if (m_size > offset && count > 0)
+        {
+            const size_t len = FFMIN(count, m_size - offset);
+            slices.push_back({&m_data[offset], static_cast<uint32_t>(len)});
+            count -= len;
+        }
+        for (auto slice = m_slices.begin(); slice != m_slices.end() && count > 0; ++slice)
+        {
+            const size_t len = FFMIN(slice->size, count);
+            slices.push_back({slice->data, static_cast<uint32_t>(len)});
+            count -= len;
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return m_size + m_sliceSize; }
+
+    uint8_t* data()
+    {
+        gather();
+        return m_data.empty() ? nullptr : m_data.data();
+    }
+
+    [[nodiscard]] bool isEmpty() const { return size() == 0; }
+
+    void clear()
+    {
+        m_size = 0;
+        m_slices.clear();
+        m_sliceSize = 0;
+    }
 
    private:
+    void growData(const size_t num)
+    {
+        m_size += num;
+        if (m_data.size() < m_size)
+        {
+            m_data.resize(FFMIN(m_size * 2, m_size + 1024LL * 1024));
+        }
+    }
+
     std::vector<uint8_t> m_data;
     size_t m_size;
+    std::vector<DataSlice> m_slices;  // data appended by appendRef(), it follows the first m_size bytes
+    size_t m_sliceSize;
 };
 
 typedef MemoryBlock StreamData;
@@ -113,6 +208,14 @@ class AbstractDemuxer
         discardSize = 0;
         return 0;
     }
+    //! Skip the data before the given times of the tracks
+    /*!
+        times maps the tracks to the time (in the internal clock units from the start of the track) the reading should
+        start at. The demuxer continues from a random access point preceding all of them, and replaces each time by
+        the time of the first data it delivers for the track. A track whose data carries its own timestamps is removed
+        from the map. Must be called before the first simpleDemuxBlock(). Returns false if the demuxer can't seek.
+    */
+    virtual bool seekToTime(std::map<int32_t, int64_t>&) { return false; }
     virtual void terminate() {}
     virtual int getLastReadRez() = 0;
     virtual void getTrackList(std::map<int32_t, TrackInfo>& trackList) {}
@@ -1,12 +1,22 @@
 #ifndef ABSTRACT_READER_H_
 #define ABSTRACT_READER_H_
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 struct CodecInfo;
+class FileNameIterator;
 
 typedef std::string translateStreamName(const std::string& streamName);
 
+//! A part of the data returned by AbstractReader::readSlices()
+struct DataSlice
+{
+    const uint8_t* data;
+    uint32_t size;
+};
+
 class AbstractReader
 {
    public:
@@ -19,7 +29,21 @@ class AbstractReader
     AbstractReader() : m_blockSize(0), m_allocSize(0), m_prereadThreshold(0) {}
     virtual ~AbstractReader() = default;
     virtual uint8_t* readBlock(int readerID, uint32_t& readCnt, int& rez, bool* firstBlockVar = nullptr) = 0;
+    //! Read the next block as a list of buffers instead of one contiguous buffer
+    /*!
+            Lets a container reader return the payload of a track where the demuxer left it, without gathering it
+            first. The buffers are valid until the next read from the same reader object, so they must be copied at
+            once. rez is set as by readBlock().
+            \return false if the reader does not support it, readBlock() must be used instead
+    */
+    virtual bool readSlices(int, std::vector<DataSlice>&, uint32_t&, int&) { return false; }
     virtual bool seek(int readerID, int64_t offset) = 0;
+    //! Move the read position by offset bytes from the end of the data read so far
+    /*!
+            A reader which reads ahead may only run the seek before its next read. Then the return value only tells
+            that the seek is queued, and a failed seek is reported by the next readBlock(): it returns no data and
+            sets rez to DATA_EOF.
+    */
     virtual bool incSeek(int readerID, int64_t offset) = 0;
     virtual void notify(int readerID, uint32_t dataReaded) = 0;
     virtual int createReader(int readBuffOffset = 0) = 0;
@@ -34,6 +58,8 @@ class AbstractReader
     virtual uint32_t getPreReadThreshold() { return m_prereadThreshold; }
 
     virtual bool gotoByte(int readerID, int64_t seekDist) = 0;
+    // Switch to the next file of the list at the end of the current one. Returns false if it is not supported
+    virtual bool setFileIterator(FileNameIterator*, int) { return false; }
 
    protected:
     uint32_t m_blockSize;
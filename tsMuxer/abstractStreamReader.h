@@ -3,6 +3,7 @@
 
 #include <fs/file.h>
 
+#include "abstractReader.h"
 #include "avCodecs.h"
 #include "avPacket.h"
 #include "pesPacket.h"
@@ -55,6 +56,10 @@ class AbstractStreamReader : public BaseAbstractStreamReader
         m_curPos = m_buffer = data;
         m_bufEnd = m_buffer + dataLen;
     }
+    //! True if the reader copies its input into its own buffer, so it can take it by setBufferSlices()
+    [[nodiscard]] virtual bool gathersSlices() const { return false; }
+    //! Same as setBuffer() for the data returned by AbstractReader::readSlices(). It is not kept after the call
+    virtual void setBufferSlices(const std::vector<DataSlice>&, uint32_t, bool = false) {}
     virtual int getTmpBufferSize() { return MAX_AV_PACKET_SIZE; }
     virtual int readPacket(AVPacket& avPacket) = 0;
     virtual int flushPacket(AVPacket& avPacket) = 0;
@@ -64,6 +69,7 @@ class AbstractStreamReader : public BaseAbstractStreamReader
     virtual void setStreamIndex(const int index) { m_streamIndex = index; }
     [[nodiscard]] int getStreamIndex() const { return m_streamIndex; }
     virtual void setTimeOffset(const int64_t offset) { m_timeOffset = offset; }
+    [[nodiscard]] int64_t getTimeOffset() const { return m_timeOffset; }
     unsigned m_flags;
     virtual const CodecInfo& getCodecInfo() = 0;  // get codecInfo struct. (CodecID, codec name)
     void setSrcContainerType(const ContainerType containerType) { m_containerType = containerType; }
@@ -279,7 +279,7 @@ void BlurayHelper::close()
 }
 
 bool BlurayHelper::open(const string& dst, const DiskType dt, const int64_t diskSize, const int extraISOBlocks,
-                        const bool useReproducibleIsoHeader)
+                        const bool useReproducibleIsoHeader, const bool directIo)
 {
     m_dstPath = toNativeSeparators(dst);
 
@@ -290,7 +290,7 @@ bool BlurayHelper::open(const string& dst, const DiskType dt, const int64_t disk
     {
         m_isoWriter = new IsoWriter(useReproducibleIsoHeader ? IsoHeaderData::reproducible() : IsoHeaderData::normal());
         m_isoWriter->setLayerBreakPoint(0xBA7200);  // around 25Gb
-        return m_isoWriter->open(m_dstPath, diskSize, extraISOBlocks);
+        return m_isoWriter->open(m_dstPath, diskSize, extraISOBlocks, directIo);
     }
     m_dstPath = closeDirPath(m_dstPath, getDirSeparator());
     return true;
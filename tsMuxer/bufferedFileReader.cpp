@@ -2,6 +2,8 @@
 
 #include <fs/systemlog.h>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "vodCoreException.h"
@@ -10,15 +12,36 @@
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <fcntl.h>
 #endif
 
 using namespace std;
 
+// the input is dropped from the page cache this far behind the read position, so the demuxers can still seek back
+// a little (e.g. after reading the track list) without reading from the disk again
+static constexpr int64_t DROP_CACHE_LAG = 16 * DEFAULT_FILE_BLOCK_SIZE;
+// the beginning of a pipe which can be read again. The stream detection does not read more than this
+static constexpr int64_t PIPE_REPLAY_SIZE = DETECT_STREAM_BUFFER_SIZE;
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+static int toFd(const File& file) { return static_cast<int>(reinterpret_cast<std::intptr_t>(file.nativeHandle())); }
+#endif
+
 bool FileReaderData::openStream()
 {
     base_class::openStream();
 
     const bool rez = m_file.open(m_streamName.c_str(), File::ofRead);
+    m_droppedPos = 0;
+    m_pipe = rez && isPipeInput(m_streamName.c_str());
+    m_pipePrefix.clear();
+    m_pipePos = 0;
+    m_readPos = 0;
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (rez && !m_pipe)
+        posix_fadvise(toFd(m_file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 
     if (!rez)
     {
@@ -37,6 +60,110 @@ bool FileReaderData::openStream()
     return rez;
 }
 
+int FileReaderData::readBlock(uint8_t* buffer, const uint32_t max_size)
+{
+    if (!m_pipe)
+        return m_file.read(buffer, max_size);
+
+    uint32_t replayed = 0;
+    if (m_readPos < m_pipePos)
+    {
+        // the demuxer has seeked back, the data is taken from the kept beginning of the stream
+        replayed = static_cast<uint32_t>(std::min<int64_t>(max_size, m_pipePos - m_readPos));
+        memcpy(buffer, m_pipePrefix.data() + m_readPos, replayed);
+        m_readPos += replayed;
+        if (replayed == max_size)
+            return static_cast<int>(replayed);
+    }
+    const int rez = readPipe(buffer + replayed, max_size - replayed);
+    if (rez < 0)
+        return replayed > 0 ? static_cast<int>(replayed) : rez;
+    return static_cast<int>(replayed) + rez;
+}
+
+int FileReaderData::readPipe(uint8_t* buffer, const uint32_t size)
+{
+    // a pipe returns whatever data is available, but a short block means the end of the file to the reader
+    uint32_t total = 0;
+    while (total < size)
+    {
+        const int rez = m_file.read(buffer + total, size - total);
+        if (rez <= 0)
+        {
+            if (total == 0)
+                return rez;
+            break;
+        }
+        total += static_cast<uint32_t>(rez);
+    }
+    if (m_pipePos < PIPE_REPLAY_SIZE)
+    {
+        const auto keepSize = static_cast<size_t>(std::min<int64_t>(total, PIPE_REPLAY_SIZE - m_pipePos));
+        m_pipePrefix.insert(m_pipePrefix.end(), buffer, buffer + keepSize);
+    }
+    else if (!m_pipePrefix.empty())
+    {
+        std::vector<uint8_t>().swap(m_pipePrefix);
+    }
+    m_pipePos += total;
+    m_readPos = m_pipePos;
+    return static_cast<int>(total);
+}
+
+bool FileReaderData::incSeek(const int64_t offset)
+{
+    if (m_pipe)
+        return setReadPosition(m_readPos + offset);
+    return m_file.seek(offset, File::SeekMethod::smCurrent) != -1;
+}
+
+int64_t FileReaderData::readPosition() { return m_pipe ? m_readPos : m_file.seek(0, File::SeekMethod::smCurrent); }
+
+bool FileReaderData::setReadPosition(const int64_t pos)
+{
+    if (!m_pipe)
+        return m_file.seek(pos) == pos;
+    if (pos < 0)
+        return false;
+    if (pos <= m_pipePos)
+    {
+        // only the data which is still kept can be read again
+        if (pos < m_pipePos && m_pipePos > static_cast<int64_t>(m_pipePrefix.size()))
+            return false;
+        m_readPos = pos;
+        return true;
+    }
+    // skip the data up to the new position
+    std::vector<uint8_t> skipBuffer(DEFAULT_FILE_BLOCK_SIZE);
+    m_readPos = m_pipePos;
+    while (m_pipePos < pos)
+    {
+        const auto size = static_cast<uint32_t>(std::min<int64_t>(skipBuffer.size(), pos - m_pipePos));
+        if (readPipe(skipBuffer.data(), size) <= 0)
+            return false;
+    }
+    return true;
+}
+
+void FileReaderData::adviseCache()
+{
+    if (m_pipe)
+        return;
+#if !defined(_WIN32) && !defined(__APPLE__)
+    const int fd = toFd(m_file);
+    const int64_t pos = readPosition();
+    if (pos < 0)
+        return;
+    // start reading the next block while this one is processed
+    posix_fadvise(fd, pos, m_blockSize, POSIX_FADV_WILLNEED);
+    if (m_dropCache && pos - DROP_CACHE_LAG > m_droppedPos)
+    {
+        posix_fadvise(fd, m_droppedPos, pos - DROP_CACHE_LAG - m_droppedPos, POSIX_FADV_DONTNEED);
+        m_droppedPos = pos - DROP_CACHE_LAG;
+    }
+#endif
+}
+
 BufferedFileReader::BufferedFileReader(const uint32_t blockSize, const uint32_t allocSize,
                                        const uint32_t prereadThreshold)
     : BufferedReader(blockSize, allocSize, prereadThreshold)
@@ -56,6 +183,12 @@ bool BufferedFileReader::openStream(const int readerID, const char* streamName,
     data->m_lastBlock = false;
     data->m_streamName = streamName;
     data->m_fileHeaderSize = 0;
+    {
+        std::lock_guard lk(m_readMtx);
+        data->m_seekPending = false;
+        data->m_eof = false;
+        data->discardReadAhead();
+    }
     data->closeStream();
     if (!data->openStream())
     {
@@ -68,15 +201,13 @@ bool BufferedFileReader::gotoByte(const int readerID, const int64_t seekDist)
     const auto data = dynamic_cast<FileReaderData*>(getReader(readerID));
     if (data)
     {
-        data->m_blockSize = m_blockSize - static_cast<uint32_t>(seekDist % static_cast<uint64_t>(m_blockSize));
-        const uint64_t seekRez = data->m_file.seek(seekDist + data->m_fileHeaderSize, File::SeekMethod::smBegin);
-        const bool rez = seekRez != static_cast<uint64_t>(-1);
-        if (rez)
+        // the seek itself is done by the reader thread, so it can't interfere with a read in progress
         {
-            data->m_eof = false;
-            data->m_notified = false;
+            std::lock_guard lk(m_readMtx);
+            data->m_blockSize = m_blockSize - static_cast<uint32_t>(seekDist % static_cast<uint64_t>(m_blockSize));
         }
-        return rez;
+        requestSeek(data, seekDist + data->m_fileHeaderSize, false);
+        return true;
     }
     return false;
 }
@@ -18,6 +18,9 @@ class FileListIterator final : public FileNameIterator
     std::string getNextName() override { return ++m_index < m_files.size() ? m_files[m_index] : ""; }
 
     void addFile(const std::string& fileName) { m_files.push_back(fileName); }
+    [[nodiscard]] const std::vector<std::string>& getFiles() const { return m_files; }
+    // the next name is the one after the file with the given index
+    void setCurrentFile(const size_t index) { m_index = index; }
 
    private:
     std::vector<std::string> m_files;
@@ -28,18 +31,38 @@ struct FileReaderData final : ReaderData
 {
     typedef ReaderData base_class;
 
-    FileReaderData(uint32_t blockSize, uint32_t allocSize) : m_fileHeaderSize(0) {}
+    FileReaderData(uint32_t, uint32_t)
+        : m_fileHeaderSize(0), m_droppedPos(0), m_pipe(false), m_pipePos(0), m_readPos(0)
+    {
+    }
 
     ~FileReaderData() override = default;
 
-    int readBlock(uint8_t* buffer, const uint32_t max_size) override { return m_file.read(buffer, max_size); }
+    int readBlock(uint8_t* buffer, uint32_t max_size) override;
 
     bool openStream() override;
     bool closeStream() override { return m_file.close(); }
-    bool incSeek(const int64_t offset) override { return m_file.seek(offset, File::SeekMethod::smCurrent) != -1; }
+    bool incSeek(int64_t offset) override;
+
+    // a pipe can't be read at a given position, so it is always read synchronously
+    void* nativeHandle() override { return m_file.isOpen() && !m_pipe ? m_file.nativeHandle() : nullptr; }
+    int64_t readPosition() override;
+    bool setReadPosition(int64_t pos) override;
+    void adviseCache() override;
 
     File m_file;
     uint32_t m_fileHeaderSize;
+    int64_t m_droppedPos;  // data before this offset was dropped from the page cache
+
+    // the standard input or a named pipe can be read only once. The beginning of the stream is kept, so the demuxers
+    // can seek back after the stream detection
+    bool m_pipe;
+    std::vector<uint8_t> m_pipePrefix;
+    int64_t m_pipePos;  // number of bytes read from the pipe
+    int64_t m_readPos;  // position of the next read, before m_pipePos while the kept data is replayed
+
+   private:
+    int readPipe(uint8_t* buffer, uint32_t size);
 };
 
 class BufferedFileReader final : public BufferedReader
@@ -3,77 +3,307 @@
 
 #include <fs/systemlog.h>
 
-void WriterData::execute() const
+#include <algorithm>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+void WriterData::execute(IoBufferPool* bufferPool) const
 {
     switch (m_command)
     {
     case Commands::wdWrite:
-        if (m_mainFile)
-        {
-            m_mainFile->write(m_buffer, m_bufferLen);
-        }
-        delete[] m_buffer;
+    {
+        const bool written = m_mainFile == nullptr || m_mainFile->write(m_buffer, m_bufferLen) == m_bufferLen;
+        if (bufferPool)
+            bufferPool->release(m_buffer);
+        else
+            freeIoBuffer(m_buffer);
+        if (!written)
+            throw std::runtime_error("Can't write to the output file");
         break;
+    }
     default:
         break;
     }
 }
 
-BufferedFileWriter::BufferedFileWriter() : m_terminated(false), m_writeQueue(WRITE_QUEUE_MAX_SIZE)
+bool WriteBudget::tryAcquire()
+{
+    uint32_t used = m_used.load(std::memory_order_relaxed);
+    do
+    {
+        if (used >= m_limit)
+            return false;
+    } while (!m_used.compare_exchange_weak(used, used + 1, std::memory_order_relaxed));
+    if (used + 1 > m_maxUsed.load(std::memory_order_relaxed))
+        m_maxUsed.store(used + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void WriteBudget::acquire()
+{
+    while (!tryAcquire())
+        m_waiter.waitNotFull([this] { return m_used.load(std::memory_order_relaxed) < m_limit; });
+}
+
+void WriteBudget::release(const uint32_t count)
+{
+    m_used.fetch_sub(count, std::memory_order_relaxed);
+    m_waiter.notifyNotFull();
+}
+
+BufferedFileWriter::BufferedFileWriter(IoBufferPool* bufferPool, WriteBudget* budget, const uint32_t maxBatchSize)
+    : m_bufferPool(bufferPool),
+      m_budget(budget),
+      m_maxBatchSize(std::max(maxBatchSize, 1u)),
+      m_failed(false),
+      m_terminated(false),
+      m_writeQueue(budget->limit()),
+      m_pending(0)
 {
-    m_lastErrorCode = 0;
-    m_nothingToExecute = true;
     run(this);
 }
 
 BufferedFileWriter::~BufferedFileWriter()
 {
     terminate();
-    while (!m_writeQueue.empty())
+    WriterData writerData;
+    while (m_writeQueue.tryPop(writerData)) writerData.execute(m_bufferPool);
+}
+
+void BufferedFileWriter::push(const WriterData& data)
+{
+    if (m_failed.load(std::memory_order_acquire))
+        throw std::runtime_error(m_lastErrorStr);
+    if (!m_budget->tryAcquire())
     {
-        WriterData writerData = m_writeQueue.pop();
-        writerData.execute();
+        const auto stallStart = std::chrono::steady_clock::now();
+        m_budget->acquire();
+        m_stats.stallCnt++;
+        m_stats.stallTime += std::chrono::steady_clock::now() - stallStart;
     }
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    // never blocks: the queue can hold the whole budget
+    m_writeQueue.push(data);
+    m_stats.maxQueueSize = std::max(m_stats.maxQueueSize, static_cast<uint32_t>(m_writeQueue.size()));
+}
+
+void BufferedFileWriter::drain()
+{
+    {
+        std::unique_lock lk(m_mtx);
+        m_drainCond.wait(lk, [this] { return m_pending.load(std::memory_order_acquire) == 0; });
+    }
+    if (m_failed.load(std::memory_order_acquire))
+        throw std::runtime_error(m_lastErrorStr);
+}
+
+WriteStats BufferedFileWriter::getWriteStats() { return m_stats; }
+
+void BufferedFileWriter::execute(const std::vector<WriterData>& batch) const
+{
+    if (batch.size() == 1)
+    {
+        batch[0].execute(m_bufferPool);
+        return;
+    }
+    std::vector<IoSlice> slices;
+    slices.reserve(batch.size());
+    int64_t size = 0;
+    for (const auto& data : batch)
+    {
+        slices.push_back({data.m_buffer, static_cast<uint32_t>(data.m_bufferLen)});
+        size += data.m_bufferLen;
+    }
+    const bool written = batch[0].m_mainFile == nullptr ||
+                         batch[0].m_mainFile->writev(slices.data(), static_cast<int>(slices.size())) == size;
+    for (const auto& data : batch)
+    {
+        if (m_bufferPool)
+            m_bufferPool->release(data.m_buffer);
+        else
+            freeIoBuffer(data.m_buffer);
+    }
+    if (!written)
+        throw std::runtime_error("Can't write to the output file");
 }
 
 void BufferedFileWriter::thread_main()
 {
-    while (!m_terminated)
+    std::vector<WriterData> batch;
+    while (true)
     {
-        WriterData writerData = m_writeQueue.pop();
+        batch.push_back(m_writeQueue.pop());
+        if (m_terminated.load(std::memory_order_acquire) && batch[0].m_command == WriterData::Commands::wdNone)
+            break;
+        // take the following writes to the same stream as well
+        if (batch[0].m_command == WriterData::Commands::wdWrite)
+        {
+            const WriterData* next;
+            while (batch.size() < m_maxBatchSize && (next = m_writeQueue.front()) != nullptr &&
+                   next->m_command == WriterData::Commands::wdWrite && next->m_mainFile == batch[0].m_mainFile)
+                batch.push_back(m_writeQueue.pop());
+        }
+        std::string errorStr;
         try
         {
-            writerData.execute();
+            execute(batch);
         }
         catch (std::runtime_error& e)
         {
-            m_lastErrorStr = e.what();
-            m_lastErrorCode = -1;
+            errorStr = e.what();
             LTRACE(LT_ERROR, 0, "BufferedFileWriter::thread_main() throws runtime_error: " << e.what());
         }
         catch (std::exception& e)
         {
-            m_lastErrorStr = e.what();
-            m_lastErrorCode = -1;
+            errorStr = e.what();
             LTRACE(LT_ERROR, 0, "BufferedFileWriter::thread_main() throws exception: " << e.what());
         }
         catch (...)
         {
-            m_lastErrorStr = "Unknown expcetion";
-            m_lastErrorCode = -1;
+            errorStr = "Unknown expcetion";
             LTRACE(LT_ERROR, 0, "BufferedFileWriter::thread_main() throws unknown exception");
         }
-        m_nothingToExecute = m_writeQueue.empty();
+        if (!errorStr.empty() && !m_failed.load(std::memory_order_relaxed))
+        {
+            m_lastErrorStr = errorStr;
+            m_failed.store(true, std::memory_order_release);
+        }
+        const auto written = static_cast<uint32_t>(batch.size());
+        batch.clear();
+        m_budget->release(written);
+        if (m_pending.fetch_sub(written, std::memory_order_acq_rel) == written)
+        {
+            std::lock_guard lk(m_mtx);
+            m_drainCond.notify_all();
+        }
     }
 }
 
 void BufferedFileWriter::terminate()
 {
-    if (m_terminated)
+    if (m_terminated.exchange(true))
         return;
-    m_terminated = true;
-    WriterData data;
-    data.m_command = WriterData::Commands::wdNone;
-    m_writeQueue.push(data);
+    // wakes up the writer once the data queued before is written
+    m_writeQueue.push(WriterData());
     join();
 }
+
+namespace
+{
+// writers are assigned by this key. Virtual files (ISO image) are always written by the same writer
+uint64_t destinationOf(AbstractOutputStream* file, const bool perFile)
+{
+    const auto realFile = dynamic_cast<File*>(file);
+    if (realFile == nullptr)
+        return 0;
+    if (perFile)
+        return reinterpret_cast<std::uintptr_t>(file);
+#ifndef _WIN32
+    struct stat st;
+    if (fstat(static_cast<int>(reinterpret_cast<std::intptr_t>(realFile->nativeHandle())), &st) == 0)
+        return static_cast<uint64_t>(st.st_dev) + 1;
+#endif
+    return 0;
+}
+}  // namespace
+
+BufferedFileWriterPool::BufferedFileWriterPool(IoBufferPool* bufferPool, const uint32_t maxQueueSize,
+                                               const uint32_t maxBatchSize, const uint32_t maxWriters,
+                                               const bool writerPerFile)
+    : m_bufferPool(bufferPool),
+      m_budget(maxQueueSize),
+      m_maxBatchSize(maxBatchSize),
+      m_maxWriters(std::max(maxWriters, 1u)),
+      m_writerPerFile(writerPerFile)
+{
+}
+
+BufferedFileWriterPool::~BufferedFileWriterPool()
+{
+    for (const auto& writer : m_writers) delete writer;
+}
+
+BufferedFileWriter* BufferedFileWriterPool::getWriter(AbstractOutputStream* file)
+{
+    // the destination is resolved at the first write of a file, which follows its opening
+    const auto fileWriter = m_fileWriters.find(file);
+    if (fileWriter != m_fileWriters.end())
+        return fileWriter->second;
+    return m_fileWriters[file] = getDestinationWriter(destinationOf(file, m_writerPerFile));
+}
+
+BufferedFileWriter* BufferedFileWriterPool::getDestinationWriter(const uint64_t destination)
+{
+    const auto itr = m_destinations.find(destination);
+    if (itr != m_destinations.end())
+        return itr->second;
+
+    BufferedFileWriter* writer;
+    if (m_writers.size() < m_maxWriters)
+    {
+        writer = new BufferedFileWriter(m_bufferPool, &m_budget, m_maxBatchSize);
+        m_writers.push_back(writer);
+    }
+    else
+    {
+        // share the writer with the fewest destinations
+        writer = *std::min_element(m_writers.begin(), m_writers.end(),
+                                   [this](BufferedFileWriter* a, BufferedFileWriter* b)
+                                   { return m_destinationCnt[a] < m_destinationCnt[b]; });
+    }
+    m_destinationCnt[writer]++;
+    m_destinations[destination] = writer;
+    return writer;
+}
+
+void BufferedFileWriterPool::push(const WriterData& data)
+{
+    BufferedFileWriter* writer = getWriter(data.m_mainFile);
+    writer->push(data);
+    if (data.m_command != WriterData::Commands::wdDelete)
+        return;
+    // the file is gone once its queued writes are done, and the next file may get its address
+    m_fileWriters.erase(data.m_mainFile);
+    if (m_writerPerFile)
+    {
+        const uint64_t destination = destinationOf(data.m_mainFile, true);
+        if (destination != 0 && m_destinations.erase(destination) > 0)
+            m_destinationCnt[writer]--;
+    }
+}
+
+void BufferedFileWriterPool::drain()
+{
+    // all the writers finish their queued data before the first failure is reported
+    std::string errorStr;
+    for (const auto& writer : m_writers)
+    {
+        try
+        {
+            writer->drain();
+        }
+        catch (std::runtime_error& e)
+        {
+            if (errorStr.empty())
+                errorStr = e.what();
+        }
+    }
+    if (!errorStr.empty())
+        throw std::runtime_error(errorStr);
+}
+
+WriteStats BufferedFileWriterPool::getWriteStats()
+{
+    WriteStats rez;
+    for (const auto& writer : m_writers)
+    {
+        const WriteStats stats = writer->getWriteStats();
+        rez.stallCnt += stats.stallCnt;
+        rez.stallTime += stats.stallTime;
+    }
+    rez.maxQueueSize = m_budget.maxUsed();
+    return rez;
+}
@@ -1,14 +1,32 @@
 #ifndef BUFFERED_FILE_WRITER_H_
 #define BUFFERED_FILE_WRITER_H_
 
-#include <containers/safequeue.h>
+#include <containers/iobufferpool.h>
+#include <containers/ringqueue.h>
 #include <fs/file.h>
 #include <system/terminatablethread.h>
 #include <types/types.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "avPacket.h"
 #include "vod_common.h"
 
-constexpr unsigned WRITE_QUEUE_MAX_SIZE = 400 * 1024 * 1024 / DEFAULT_FILE_BLOCK_SIZE;  // 400 Mb max queue size
+// size of the muxer output buffers: a file block, the packet which overflows it and some extra stream data
+constexpr int WRITE_BUFFER_SIZE = DEFAULT_FILE_BLOCK_SIZE + MAX_AV_PACKET_SIZE + 4096;
+// number of output buffers kept for reuse. It is also the limit of the blocks waiting in the write queue
+constexpr unsigned WRITE_BUFFER_POOL_SIZE = 256 * 1024 * 1024 / DEFAULT_FILE_BLOCK_SIZE;
+// default number of queued blocks of a stream which are written with one call
+constexpr unsigned DEFAULT_WRITE_BATCH_SIZE = 8;
+// default maximum number of writer threads
+constexpr unsigned DEFAULT_WRITER_THREADS = 4;
 
 struct WriterData
 {
@@ -27,38 +45,105 @@ struct WriterData
 
     WriterData() : m_buffer(nullptr), m_bufferLen(0), m_mainFile(), m_command() {}
 
-    void execute() const;
+    void execute(IoBufferPool* bufferPool) const;
+};
+
+struct WriteStats
+{
+    WriteStats() : stallCnt(0), stallTime(0), maxQueueSize(0) {}
+
+    uint64_t stallCnt;  // number of push() calls which waited for the writer
+    std::chrono::nanoseconds stallTime;
+    uint32_t maxQueueSize;  // high watermark of the write queue, in blocks
+};
+
+// Number of blocks queued in all writers of a BufferedFileWriterPool. The muxer waits while it is used up
+class WriteBudget
+{
+   public:
+    explicit WriteBudget(const uint32_t limit) : m_limit(std::max(limit, 1u)), m_used(0), m_maxUsed(0) {}
+
+    [[nodiscard]] uint32_t limit() const { return m_limit; }
+    [[nodiscard]] uint32_t maxUsed() const { return m_maxUsed.load(std::memory_order_relaxed); }
+
+    // Take a block from the budget. Returns false if it is used up
+    bool tryAcquire();
+    // Take a block from the budget, waiting until one is released
+    void acquire();
+    void release(uint32_t count);
+
+   private:
+    const uint32_t m_limit;
+    std::atomic<uint32_t> m_used;
+    std::atomic<uint32_t> m_maxUsed;
+    RingQueueWaiter m_waiter;
 };
 
 class BufferedFileWriter final : public TerminatableThread
 {
    public:
-    BufferedFileWriter();
+    // Consecutive writes to the same stream are done with one writev() call, up to maxBatchSize blocks at once
+    BufferedFileWriter(IoBufferPool* bufferPool, WriteBudget* budget, uint32_t maxBatchSize);
     ~BufferedFileWriter() override;
     void terminate();
-    int getQueueSize() const { return static_cast<int>(m_writeQueue.size()); }
 
-    bool addWriterData(const WriterData& data)
-    {
-        if (m_lastErrorCode == 0)
-        {
-            m_nothingToExecute = false;
-            return m_writeQueue.push(data);
-        }
-        throw std::runtime_error(m_lastErrorStr);
-    }
-    bool isQueueEmpty() const { return m_nothingToExecute; }
+    // Queue the data for writing. Blocks while the budget is used up. Throws if a previous write failed. Must always
+    // be called from the same thread.
+    void push(const WriterData& data);
+    // Wait until all queued data is written. Throws if a write failed
+    void drain();
+    WriteStats getWriteStats();
 
    protected:
     void thread_main() override;
 
    private:
-    bool m_nothingToExecute;
-    int m_lastErrorCode;
-    std::string m_lastErrorStr;
-    bool m_terminated;
+    void execute(const std::vector<WriterData>& batch) const;
+
+    IoBufferPool* m_bufferPool;  // written buffers are returned here
+    WriteBudget* m_budget;
+    uint32_t m_maxBatchSize;
+    std::atomic<bool> m_failed;
+    std::string m_lastErrorStr;  // set once, before m_failed
+    std::atomic<bool> m_terminated;
+
+    SpscQueue<WriterData> m_writeQueue;
+    std::atomic<uint32_t> m_pending;  // blocks pushed and not written yet
+    std::mutex m_mtx;
+    std::condition_variable m_drainCond;  // signaled when m_pending drops to 0
+    WriteStats m_stats;                   // updated by push()
+};
+
+// Writer threads of the output files. The files are assigned to the writers by the device they are stored on (or
+// one writer per file), so a slow destination does not hold up the others. All writes to a file go through the same
+// writer, in order. The writers share one budget of queued blocks.
+class BufferedFileWriterPool
+{
+   public:
+    BufferedFileWriterPool(IoBufferPool* bufferPool, uint32_t maxQueueSize, uint32_t maxBatchSize,
+                           uint32_t maxWriters, bool writerPerFile);
+    ~BufferedFileWriterPool();
+
+    // Queue the data for writing. wdDelete also forgets the writer of the file. Throws if a previous write failed
+    void push(const WriterData& data);
+    // Wait until all queued data is written. Throws if a write failed
+    void drain();
+    WriteStats getWriteStats();
+    [[nodiscard]] size_t writerCount() const { return m_writers.size(); }
+
+   private:
+    BufferedFileWriter* getWriter(AbstractOutputStream* file);
+    BufferedFileWriter* getDestinationWriter(uint64_t destination);
 
-    WaitableSafeQueue<WriterData> m_writeQueue;
+    IoBufferPool* m_bufferPool;
+    WriteBudget m_budget;
+    uint32_t m_maxBatchSize;
+    uint32_t m_maxWriters;
+    bool m_writerPerFile;
+    std::vector<BufferedFileWriter*> m_writers;
+    std::map<uint64_t, BufferedFileWriter*> m_destinations;  // device or file -> writer
+    std::map<AbstractOutputStream*, BufferedFileWriter*> m_fileWriters;
+    std::map<BufferedFileWriter*, uint32_t> m_destinationCnt;
 };
 
 #endif
@@ -3,6 +3,8 @@
 
 #include <fs/systemlog.h>
 
+#include <algorithm>
+
 #include "abstractReader.h"
 #include "vod_common.h"
 
@@ -15,9 +17,28 @@ using namespace std;
 int BufferedReader::m_newReaderID = 0;
 std::mutex BufferedReader::m_genReaderMtx;
 static constexpr unsigned QUEUE_MAX_SIZE = 4096;
+static constexpr uint32_t MIN_ASYNC_CHUNK_SIZE = 256 * 1024;
+static constexpr uint32_t MAX_READ_AHEAD_BLOCKS = 4;
+
+namespace
+{
+void addStats(ReadStats& stats, const ReaderData* data)
+{
+    stats.stallCnt += data->m_stallCnt;
+    stats.stallTime += data->m_stallTime;
+    stats.maxBlockCnt = std::max(stats.maxBlockCnt, data->m_blockCnt);
+}
+}  // namespace
 
 BufferedReader::BufferedReader(const uint32_t blockSize, const uint32_t allocSize, const uint32_t prereadThreshold)
-    : m_started(false), m_terminated(false), m_readQueue(QUEUE_MAX_SIZE), m_id(0)
+    : m_started(false),
+      m_terminated(false),
+      m_readQueue(QUEUE_MAX_SIZE),
+      m_id(0),
+      m_queueDepth(0),
+      m_minReadAhead(DEFAULT_READ_AHEAD_BLOCKS),
+      m_maxReadAhead(MAX_READ_AHEAD_BLOCKS),
+      m_dropCache(true)
 {
     // size of the blocks being read
     m_blockSize = blockSize;
@@ -35,31 +56,31 @@ ReaderData* BufferedReader::getReader(const int readerID)
     return itr != m_readers.end() ? itr->second : nullptr;
 }
 
-bool BufferedReader::seek(const int readerID, const int64_t offset)
+void BufferedReader::requestSeek(ReaderData* data, const int64_t offset, const bool relative)
 {
-    const auto itr = m_readers.find(readerID);
-    if (itr != m_readers.end())
+    std::lock_guard lk(m_readMtx);
+    if (relative && data->m_seekPending)
+        data->m_seekOffset += offset;
+    else
     {
-        ReaderData* data = itr->second;
-        return data->incSeek(offset);
+        data->m_seekRelative = relative;
+        data->m_seekOffset = offset;
     }
-    return false;
+    data->m_seekPending = true;
+    data->m_eof = false;
+    data->discardReadAhead();
 }
 
+bool BufferedReader::seek(const int readerID, const int64_t offset) { return incSeek(readerID, offset); }
+
 bool BufferedReader::incSeek(const int readerID, const int64_t offset)
 {
     std::lock_guard lock(m_readersMtx);
     const auto itr = m_readers.find(readerID);
     if (itr != m_readers.end())
     {
-        ReaderData* data = itr->second;
-        const bool rez = data->incSeek(offset);
-        if (rez)
-        {
-            data->m_eof = false;
-            data->m_notified = false;
-        }
-        return rez;
+        requestSeek(itr->second, offset, true);
+        return true;
     }
     return false;
 }
@@ -90,6 +111,9 @@ int BufferedReader::createReader(const int readBuffOffset)
 
     data->m_blockSize = m_blockSize;
     data->m_allocSize = m_allocSize;
+    data->m_blockCnt = m_minReadAhead;
+    data->m_maxBlockCnt = m_maxReadAhead;
+    data->m_dropCache = m_dropCache;
 
     data->m_readOffset = readBuffOffset;
 
@@ -122,27 +146,49 @@ void BufferedReader::deleteReader(const int readerID)
             data->m_deleted = true;  // There are requests in the queue for reading into this structure.
         else
         {
+            addStats(m_stats, data);
             delete iterator->second;  // No outstanding requests for reading in the queue. Delete immediately.
             m_readers.erase(iterator);
         }
     }
 }
 
+bool BufferedReader::queueReadAhead(const int readerID, ReaderData* data, const bool fillRing)
+{
+    int requests = 0;
+    bool readPending;
+    {
+        std::lock_guard lk(m_readMtx);
+        readPending = data->m_pendingReads > 0;
+        if (data->m_eof || (readPending && !fillRing))
+            return readPending;
+        while (!data->m_freeBlocks.empty() && (fillRing || requests == 0))
+        {
+            data->m_reservedBlocks.push_back(data->m_freeBlocks.front());
+            data->m_freeBlocks.pop_front();
+            data->m_pendingReads++;
+            requests++;
+        }
+    }
+    for (int i = 0; i < requests; ++i)
+    {
+        data->m_atQueue++;
+        m_readQueue.push(readerID);
+    }
+    return readPending;
+}
+
 uint8_t* BufferedReader::readBlock(const int readerID, uint32_t& readCnt, int& rez, bool* firstBlockVar)
 {
     ReaderData* data;
+    bool readAheadPending;
     {
         std::lock_guard lock(m_readersMtx);
         const auto itr = m_readers.find(readerID);
         if (itr != m_readers.end())
         {
             data = itr->second;
-            if (!data->m_nextBlockSize && !data->m_notified)
-            {  // No fragments of this block found, and no requests for reading this block
-                data->m_notified = true;
-                data->m_atQueue++;
-                m_readQueue.push(readerID);
-            }
+            readAheadPending = queueReadAhead(readerID, data, false);  // request the next block if not requested yet
         }
         else
         {
@@ -152,20 +198,38 @@ uint8_t* BufferedReader::readBlock(const int readerID, uint32_t& readCnt, int& r
         }
     }
 
-    if (!data->m_nextBlockSize)
+    std::unique_lock lk(m_readMtx);
+    if (data->m_readyBlocks.empty() && !data->m_eof)
+    {
+        const auto stallStart = std::chrono::steady_clock::now();
+        while (data->m_readyBlocks.empty() && !data->m_eof) m_readCond.wait(lk);
+        data->m_stallCnt++;
+        data->m_stallTime += std::chrono::steady_clock::now() - stallStart;
+        if (readAheadPending && data->m_blockCnt < data->m_maxBlockCnt)
+        {
+            // the block was requested in advance, but it still was not ready. Read further ahead
+            data->m_blockCnt++;
+            data->addBlock();
+        }
+    }
+    if (data->m_readyBlocks.empty())
     {
-        std::unique_lock lk(m_readMtx);
-        while (data->m_nextBlockSize == 0 && !data->m_eof) m_readCond.wait(lk);
+        readCnt = 0;
+        rez = DATA_EOF;
+        if (firstBlockVar)
+            *firstBlockVar = data->m_firstBlock;
+        return data->m_curBlock ? data->m_curBlock : data->m_blocks.empty() ? nullptr : data->m_blocks[0];
     }
-    readCnt = data->m_nextBlockSize >= 0 ? data->m_nextBlockSize : 0;
-    rez = data->m_eof ? DATA_EOF : NO_ERROR;
-    const uint8_t prevIndex = data->m_bufferIndex;
-    data->m_bufferIndex = 1 - data->m_bufferIndex;
-    data->m_nextBlockSize = 0;
-    data->m_notified = false;
+    const ReaderData::ReadedBlock block = data->m_readyBlocks.front();
+    data->m_readyBlocks.pop_front();
+    if (data->m_curBlock)
+        data->m_freeBlocks.push_back(data->m_curBlock);
+    data->m_curBlock = block.data;
+    readCnt = block.size >= 0 ? block.size : 0;
+    rez = block.eof ? DATA_EOF : NO_ERROR;
     if (firstBlockVar)
-        *firstBlockVar = data->m_firstBlock;
-    return data->m_nextBlock[prevIndex];
+        *firstBlockVar = block.firstBlock;
+    return block.data;
 }
 
 void BufferedReader::terminate()
@@ -179,12 +243,10 @@ void BufferedReader::notify(const int readerID, const uint32_t dataReaded)
     ReaderData* data = getReader(readerID);
     if (data == nullptr)
         return;
-    if (dataReaded >= m_prereadThreshold && !data->m_notified)
+    if (dataReaded >= m_prereadThreshold)
     {
         std::lock_guard lock(m_readersMtx);
-        data->m_notified = true;
-        data->m_atQueue++;
-        m_readQueue.push(readerID);
+        queueReadAhead(readerID, data, true);
     }
 }
 
@@ -194,111 +256,339 @@ uint32_t BufferedReader::getReaderCount()
     return static_cast<uint32_t>(m_readers.size());
 }
 
+void BufferedReader::setReadAhead(const uint32_t minBlocks, const uint32_t maxBlocks)
+{
+    m_minReadAhead = std::max(DEFAULT_READ_AHEAD_BLOCKS, minBlocks);
+    m_maxReadAhead = std::max(m_minReadAhead, maxBlocks);
+}
+
+ReadStats BufferedReader::getReadStats()
+{
+    std::lock_guard lock(m_readersMtx);
+    ReadStats stats = m_stats;
+    std::lock_guard lk(m_readMtx);
+    for (const auto& reader : m_readers) addStats(stats, reader.second);
+    return stats;
+}
+
 void BufferedReader::thread_main()
 {
     try
     {
+        int readerID = m_readQueue.pop();
         while (!m_terminated)
         {
-            const int readerID = m_readQueue.pop();
-            if (m_terminated)
+            if (m_queueDepth > 0 && openAsyncQueue())
+                readerID = readAsync(readerID);
+            else
+            {
+                readSync(readerID);
+                readerID = m_readQueue.pop();
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        LTRACE(LT_ERROR, 0, "BufferedReader::thread_main() throws exception: " << e.what());
+    }
+    catch (...)
+    {
+        LTRACE(LT_ERROR, 0, "BufferedReader::thread_main() throws unknown exception");
+    }
+}
+
+bool BufferedReader::openAsyncQueue()
+{
+    if (m_asyncQueue.isOpen())
+        return true;
+    if (m_asyncQueue.open(m_queueDepth))
+    {
+        LTRACE(LT_DEBUG, 0, "Reader #" << m_id << ". Asynchronous reads enabled, queue depth " << m_asyncQueue.depth());
+        return true;
+    }
+    LTRACE(LT_WARN, 2, "Asynchronous reads are not supported by the OS. Using blocking reads.");
+    m_queueDepth = 0;
+    return false;
+}
+
+bool BufferedReader::prepareRead(ReaderData* data, uint8_t*& block, uint32_t& size, uint32_t& generation)
+{
+    std::lock_guard lk(m_readMtx);
+    if (block == nullptr)
+    {
+        if (data->m_reservedBlocks.empty())
+            return false;
+        block = data->m_reservedBlocks.front();
+        data->m_reservedBlocks.pop_front();
+    }
+    if (data->m_seekPending)
+    {
+        data->m_seekPending = false;
+        data->m_seekFailed = !(data->m_seekRelative ? data->incSeek(data->m_seekOffset)
+                                                    : data->setReadPosition(data->m_seekOffset));
+        if (data->m_seekFailed)
+            LTRACE(LT_ERROR, 2, "Can't seek in file " << data->m_streamName);
+    }
+    // an empty block is published after a failed seek, completeRead() reports it as the end of the stream
+    size = data->m_seekFailed ? 0 : data->m_blockSize;
+    data->m_blockSize = m_blockSize;
+    generation = data->m_generation;
+    return true;
+}
+
+void BufferedReader::fillBlock(ReaderData* data, uint8_t* block)
+{
+    uint32_t size;
+    uint32_t generation;
+    // the read is repeated if the demuxer has requested a seek in the meantime
+    while (!data->m_deleted && prepareRead(data, block, size, generation))
+    {
+        uint8_t* buffer = block + data->m_readOffset;
+        if (publishBlock(data, block, data->readBlock(buffer, size), size, generation))
+            break;
+    }
+}
+
+void BufferedReader::readSync(const int readerID)
+{
+    ReaderData* data = getReader(readerID);
+    if (data == nullptr)
+        return;
+    fillBlock(data, nullptr);
+    releaseRequest(readerID, data);
+}
+
+int BufferedReader::readAsync(const int readerID)
+{
+    struct PendingRead
+    {
+        int readerID;
+        ReaderData* data;
+        uint8_t* block;
+        uint32_t size;
+        uint32_t generation;
+        int64_t pos;
+        uint32_t chunkSize;
+        std::vector<int> chunkRez;
+    };
+
+    // collect the requests which are already queued, so the reads of different streams go to the OS together
+    std::vector<PendingRead> pending;
+    int nextReaderID = readerID;
+    bool stop = false;  // the destructor has queued its sentinel, nothing more is pushed to the queue
+    while (true)
+    {
+        ReaderData* data = getReader(nextReaderID);
+        uint8_t* block = nullptr;
+        uint32_t size;
+        uint32_t generation;
+        if (data && !data->m_deleted && data->nativeHandle() && prepareRead(data, block, size, generation))
+        {
+            const int64_t pos = data->readPosition();
+            if (pos >= 0 && data->setReadPosition(pos + size))
+                pending.push_back({nextReaderID, data, block, size, generation, pos, 0, {}});
+            else
+            {
+                if (pos >= 0)
+                    data->setReadPosition(pos);
+                if (!publishBlock(data, block, data->readBlock(block + data->m_readOffset, size), size, generation))
+                    fillBlock(data, block);
+                releaseRequest(nextReaderID, data);
+            }
+        }
+        else
+            readSync(nextReaderID);
+
+        if (pending.size() >= m_asyncQueue.depth() || m_readQueue.empty())
+        {
+            nextReaderID = 0;
+            break;
+        }
+        nextReaderID = m_readQueue.pop();
+        if (nextReaderID == 0 || m_terminated)
+        {
+            stop = true;
+            break;
+        }
+        const bool sameStream = std::any_of(pending.begin(), pending.end(), [&](const PendingRead& r) {
+            return r.readerID == nextReaderID && r.data->itr;
+        });
+        if (sameStream)
+        {
+            // after a short read the next file of the list is opened, so the position of the next block is unknown
+            break;
+        }
+    }
+
+    // split each block into several chunks, so single stream reads also keep the device queue busy
+    if (!pending.empty())
+    {
+        const uint32_t chunksPerBlock =
+            std::max<uint32_t>(1, std::min<uint32_t>(m_asyncQueue.depth() / static_cast<uint32_t>(pending.size()),
+                                                     m_blockSize / MIN_ASYNC_CHUNK_SIZE));
+        unsigned inFlight = 0;
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            PendingRead& r = pending[i];
+            uint8_t* buffer = r.block + r.data->m_readOffset;
+            r.chunkSize = (r.size + chunksPerBlock - 1) / chunksPerBlock;
+            for (uint32_t offset = 0; offset < r.size; offset += r.chunkSize)
+            {
+                const uint32_t len = std::min(r.chunkSize, r.size - offset);
+                const uint64_t userData = static_cast<uint64_t>(i) << 32 | r.chunkRez.size();
+                r.chunkRez.push_back(-1);
+                if (m_asyncQueue.prepareRead(r.data->nativeHandle(), buffer + offset, len, r.pos + offset, userData))
+                    inFlight++;
+            }
+        }
+        while (inFlight > 0)
+        {
+            if (!m_asyncQueue.submit(1))
             {
+                LTRACE(LT_WARN, 2, "Asynchronous read failed. Using blocking reads.");
+                m_asyncQueue.close();
+                m_queueDepth = 0;
                 break;
             }
-            ReaderData* data = getReader(readerID);
-            if (data)
+            uint64_t userData;
+            int result;
+            while (m_asyncQueue.getCompletion(userData, result))
             {
-                uint8_t* buffer = data->m_nextBlock[data->m_bufferIndex] + data->m_readOffset;
-                if (!data->m_deleted)
+                pending[userData >> 32].chunkRez[userData & 0xffffffff] = result;
+                inFlight--;
+            }
+        }
+    }
+
+    for (PendingRead& r : pending)
+    {
+        int bytesReaded = 0;
+        bool failed = false;
+        bool eof = false;
+        for (const int chunkRez : r.chunkRez)
+        {
+            // a short read is only expected at the end of the file
+            if (chunkRez < 0 || (eof && chunkRez > 0))
+            {
+                failed = true;
+                break;
+            }
+            bytesReaded += chunkRez;
+            eof |= static_cast<uint32_t>(chunkRez) < r.chunkSize;
+        }
+        uint8_t* buffer = r.block + r.data->m_readOffset;
+        if (failed || !r.data->setReadPosition(r.pos + bytesReaded))
+        {
+            // repeat the whole block with a blocking read
+            r.data->setReadPosition(r.pos);
+            bytesReaded = r.data->readBlock(buffer, r.size);
+        }
+        if (!publishBlock(r.data, r.block, bytesReaded, r.size, r.generation))
+            fillBlock(r.data, r.block);
+        releaseRequest(r.readerID, r.data);
+    }
+
+    if (stop || m_terminated)
+        return 0;
+    return nextReaderID ? nextReaderID : m_readQueue.pop();
+}
+
+int BufferedReader::completeRead(ReaderData* data, uint8_t* buffer, int bytesReaded, const uint32_t size, bool& eof)
+{
+    eof = data->m_seekFailed;
+    if (eof)
+        return 0;
+    if (data->m_lastBlock)
+    {
+        data->m_lastBlock = false;
+        data->m_firstBlock = true;
+    }
+    else if (data->m_firstBlock)
+    {
+        data->m_firstBlock = false;
+    }
+
+    if (bytesReaded <= 0 || (bytesReaded < static_cast<int>(size) && data->itr))
+    {
+        if (data->itr)
+        {
+            std::string nextFileName = data->itr->getNextName();
+            if (nextFileName != data->m_streamName)
+            {
+                data->closeStream();
+                data->m_streamName = nextFileName;
+                if (!data->m_streamName.empty() && data->openStream())
                 {
-                    int bytesReaded = data->readBlock(buffer, data->m_blockSize);
-                    if (data->m_lastBlock)
+                    if (bytesReaded == 0)
                     {
-                        data->m_lastBlock = false;
+                        // data->m_nextFileInfo = NEXT_FILE_FIRST_BLOCK;
                         data->m_firstBlock = true;
-                    }
-                    else if (data->m_firstBlock)
-                    {
-                        data->m_firstBlock = false;
-                    }
-
-                    if (bytesReaded <= 0 || (bytesReaded < static_cast<int>(data->m_blockSize) && data->itr))
-                    {
-                        if (data->itr)
-                        {
-                            std::string nextFileName = data->itr->getNextName();
-                            if (nextFileName != data->m_streamName)
-                            {
-                                data->closeStream();
-                                data->m_streamName = nextFileName;
-                                if (!data->m_streamName.empty() && data->openStream())
-                                {
-                                    if (bytesReaded == 0)
-                                    {
-                                        // data->m_nextFileInfo = NEXT_FILE_FIRST_BLOCK;
-                                        data->m_firstBlock = true;
-                                        bytesReaded = data->readBlock(buffer, m_blockSize);
-                                        if (bytesReaded < static_cast<int>(m_blockSize))
-                                        {
-                                            data->m_eof = true;
-                                            data->m_lastBlock = true;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        data->m_lastBlock = true;
-                                    }
-                                }
-                                else
-                                    data->m_eof = true;
-                            }
-                        }
-                        else
+                        bytesReaded = data->readBlock(buffer, m_blockSize);
+                        if (bytesReaded < static_cast<int>(m_blockSize))
                         {
-                            data->m_eof = true;
+                            eof = true;
+                            data->m_lastBlock = true;
                         }
                     }
-
-                    data->m_blockSize = m_blockSize;
-                    if (bytesReaded == 0)
-                    {
-                        data->m_eof = true;
-                    }
-
+                    else
                     {
-                        std::lock_guard lk(m_readMtx);
-                        data->m_nextBlockSize = bytesReaded;
-                        m_readCond.notify_one();
-                    }
-                }
-
-                {
-                    std::lock_guard lock(m_readersMtx);
-                    data->m_atQueue--;
-                    if (data->m_deleted && data->m_atQueue == 0)
-                    {
-                        delete data;
-                        m_readers.erase(readerID);
+                        data->m_lastBlock = true;
                     }
                 }
+                else
+                    eof = true;
             }
         }
+        else
+        {
+            eof = true;
+        }
     }
-    catch (std::exception& e)
+
+    if (bytesReaded == 0)
     {
-        LTRACE(LT_ERROR, 0, "BufferedReader::thread_main() throws exception: " << e.what());
+        eof = true;
     }
-    catch (...)
+    return bytesReaded;
+}
+
+bool BufferedReader::publishBlock(ReaderData* data, uint8_t* block, int bytesReaded, const uint32_t size,
+                                  const uint32_t generation)
+{
+    bool eof;
+    if (bytesReaded > 0)
+        data->adviseCache();
+    bytesReaded = completeRead(data, block + data->m_readOffset, bytesReaded, size, eof);
+
+    std::lock_guard lk(m_readMtx);
+    if (generation != data->m_generation)
+        return false;
+    data->m_pendingReads--;
+    data->m_readyBlocks.push_back({block, bytesReaded, data->m_firstBlock, eof});
+    if (eof)
+        data->m_eof = true;
+    m_readCond.notify_all();
+    return true;
+}
+
+void BufferedReader::releaseRequest(const int readerID, ReaderData* data)
+{
+    std::lock_guard lock(m_readersMtx);
+    data->m_atQueue--;
+    if (data->m_deleted && data->m_atQueue == 0)
     {
-        LTRACE(LT_ERROR, 0, "BufferedReader::thread_main() throws unknown exception");
+        addStats(m_stats, data);
+        delete data;
+        m_readers.erase(readerID);
     }
 }
 
-void BufferedReader::setFileIterator(FileNameIterator* itr, const int readerID)
+bool BufferedReader::setFileIterator(FileNameIterator* itr, const int readerID)
 {
     assert(readerID != -1);
     std::lock_guard lock(m_readersMtx);
     const auto reader = m_readers.find(readerID);
     if (reader != m_readers.end())
         reader->second->itr = itr;
+    return true;
 }
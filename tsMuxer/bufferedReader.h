@@ -1,57 +1,81 @@
 #ifndef BUFFERED_READER_H_
 #define BUFFERED_READER_H_
 
-#include <containers/safequeue.h>
+#include <containers/ringqueue.h>
+#include <fs/asyncreadqueue.h>
 #include <system/terminatablethread.h>
 
+#include <chrono>
+#include <deque>
 #include <map>
 #include <string>
 
 #include "abstractDemuxer.h"
 #include "abstractReader.h"
 
+// the blocks each stream reads ahead of the demuxer at least
+static constexpr uint32_t DEFAULT_READ_AHEAD_BLOCKS = 2;
+
 struct ReaderData
 {
+    struct ReadedBlock
+    {
+        uint8_t* data;
+        int size;
+        bool firstBlock;
+        bool eof;
+    };
+
     ReaderData()
-        : m_bufferIndex(0),
-          m_notified(false),
-          m_nextBlockSize(0),
-          m_deleted(false),
+        : m_deleted(false),
           m_firstBlock(false),
           m_lastBlock(false),
           m_eof(false),
           m_atQueue(0),
           itr(nullptr),
+          m_curBlock(nullptr),
+          m_pendingReads(0),
+          m_blockCnt(2),
+          m_maxBlockCnt(2),
+          m_generation(0),
+          m_seekPending(false),
+          m_seekRelative(false),
+          m_seekOffset(0),
+          m_seekFailed(false),
+          m_stallCnt(0),
+          m_stallTime(0),
           m_blockSize(0),
           m_allocSize(0),
-          m_readOffset(0)
+          m_readOffset(0),
+          m_dropCache(false)
     {
-        m_nextBlock[0] = nullptr;
-        m_nextBlock[1] = nullptr;
     }
 
     virtual ~ReaderData()
     {
-        // deleteNextBlocks();
-        delete[] m_nextBlock[0];
-        delete[] m_nextBlock[1];
+        for (const auto block : m_blocks) delete[] block;
     }
-    /*
-virtual void deleteNextBlocks()
-{
-    delete [] m_nextBlock[0];
-    delete [] m_nextBlock[1];
-}
-    */
-    virtual bool incSeek(int64_t offset) { return true; }
+
+    virtual bool incSeek(int64_t) { return true; }
 
     virtual void init()
     {
-        // deleteNextBlocks();
-        if (m_nextBlock[0] == nullptr)
-            m_nextBlock[0] = new uint8_t[m_allocSize];
-        if (m_nextBlock[1] == nullptr)
-            m_nextBlock[1] = new uint8_t[m_allocSize];
+        if (m_blocks.empty())
+            while (m_blocks.size() < m_blockCnt) addBlock();
+    }
+
+    void addBlock()
+    {
+        m_blocks.push_back(new uint8_t[m_allocSize]);
+        m_freeBlocks.push_back(m_blocks.back());
+    }
+
+    // drop the blocks which were read ahead. Reads in progress are repeated by the reader thread
+    void discardReadAhead()
+    {
+        for (const auto& block : m_readyBlocks) m_freeBlocks.push_back(block.data);
+        m_readyBlocks.clear();
+        m_generation++;
     }
 
     virtual bool openStream()
@@ -64,20 +88,56 @@ virtual void deleteNextBlocks()
 
     virtual bool closeStream() = 0;
 
-    uint8_t m_bufferIndex;
-    bool m_notified;
-    int m_nextBlockSize;
+    // positional access used by the asynchronous read path. Streams without a native handle are read synchronously
+    virtual void* nativeHandle() { return nullptr; }
+    virtual int64_t readPosition() { return -1; }
+    virtual bool setReadPosition(int64_t) { return false; }
+    // called by the reader thread after each block read from the stream
+    virtual void adviseCache() {}
+
     bool m_deleted;
     bool m_firstBlock;
     bool m_lastBlock;
     bool m_eof;
     int m_atQueue;
     FileNameIterator* itr;
-    uint8_t* m_nextBlock[2];
+
+    // read-ahead ring: each block is either free, reserved by a queued read request, ready to be consumed or
+    // handed out to the demuxer (m_curBlock, valid until the next readBlock call)
+    std::vector<uint8_t*> m_blocks;
+    std::deque<uint8_t*> m_freeBlocks;
+    std::deque<uint8_t*> m_reservedBlocks;
+    std::deque<ReadedBlock> m_readyBlocks;
+    uint8_t* m_curBlock;
+    uint32_t m_pendingReads;  // reads queued or in progress, up to the moment the block is published
+    uint32_t m_blockCnt;
+    uint32_t m_maxBlockCnt;
+
+    // seek requested by the demuxer, executed by the reader thread before the next read
+    uint32_t m_generation;
+    bool m_seekPending;
+    bool m_seekRelative;
+    int64_t m_seekOffset;
+    bool m_seekFailed;  // the stream ends until the next seek
+
+    // time the demuxer spent waiting for data
+    uint64_t m_stallCnt;
+    std::chrono::nanoseconds m_stallTime;
+
     uint32_t m_blockSize;
     uint32_t m_allocSize;
     std::string m_streamName;
     int m_readOffset;
+    bool m_dropCache;  // drop the data which was read from the OS page cache
+};
+
+struct ReadStats
+{
+    ReadStats() : stallCnt(0), stallTime(0), maxBlockCnt(0) {}
+
+    uint64_t stallCnt;
+    std::chrono::nanoseconds stallTime;
+    uint32_t maxBlockCnt;  // largest read-ahead ring used by a stream
 };
 
 class BufferedReader : public AbstractReader, TerminatableThread
@@ -93,26 +153,54 @@ class BufferedReader : public AbstractReader, TerminatableThread
                 uint32_t dataReaded) override;  // reader must call notificate when part of data handled
     uint32_t getReaderCount();
     void terminate();
-    void setFileIterator(FileNameIterator* itr, int readerID);
+    bool setFileIterator(FileNameIterator* itr, int readerID) override;
     bool seek(int readerID, int64_t offset) override;
     bool incSeek(int readerID, int64_t offset) override;
     bool gotoByte(int readerID, int64_t seekDist) override { return false; }
 
     void setId(const uint32_t value) { m_id = value; }
 
+    // Number of reads kept in flight by the asynchronous (io_uring) read path. 0 - use blocking reads
+    void setQueueDepth(const uint32_t value) { m_queueDepth = value; }
+    [[nodiscard]] uint32_t getQueueDepth() const { return m_queueDepth; }
+
+    // Size of the per-stream read-ahead ring. The ring starts with minBlocks blocks and grows up to maxBlocks
+    // each time the demuxer has to wait for a block which was already requested.
+    void setReadAhead(uint32_t minBlocks, uint32_t maxBlocks);
+    // Drop the input from the OS page cache once it is consumed. Applies to the streams created afterwards
+    void setDropCache(bool value) { m_dropCache = value; }
+    ReadStats getReadStats();
+
    protected:
     virtual ReaderData* intCreateReader() = 0;
     void thread_main() override;
+    void readSync(int readerID);
+    int readAsync(int readerID);
+    bool prepareRead(ReaderData* data, uint8_t*& block, uint32_t& size, uint32_t& generation);
+    void fillBlock(ReaderData* data, uint8_t* block);
+    int completeRead(ReaderData* data, uint8_t* buffer, int bytesReaded, uint32_t size, bool& eof);
+    bool publishBlock(ReaderData* data, uint8_t* block, int bytesReaded, uint32_t size, uint32_t generation);
+    void releaseRequest(int readerID, ReaderData* data);
+    bool queueReadAhead(int readerID, ReaderData* data, bool fillRing);
+    void requestSeek(ReaderData* data, int64_t offset, bool relative);
 
     bool m_started;
     bool m_terminated;
-    WaitableSafeQueue<int> m_readQueue;
+    MpscQueue<int> m_readQueue;  // streams to read a block for, pushed by the demuxers
     ReaderData* getReader(int readerID);
     std::condition_variable m_readCond;
     std::mutex m_readMtx;
 
    private:
+    bool openAsyncQueue();
+
     uint32_t m_id;
+    uint32_t m_queueDepth;
+    uint32_t m_minReadAhead;
+    uint32_t m_maxReadAhead;
+    bool m_dropCache;
+    ReadStats m_stats;
+    AsyncReadQueue m_asyncQueue;
     std::mutex m_readersMtx;
     std::map<int, ReaderData*> m_readers;
     static int m_newReaderID;
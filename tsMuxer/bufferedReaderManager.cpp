@@ -1,22 +1,31 @@
 #include "bufferedReaderManager.h"
 
+#include <algorithm>
 #include <climits>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
 
 using namespace std;
 
+// device of the files which can't be examined
+static constexpr uint64_t UNKNOWN_DEVICE = 0;
+// devices set by addDeviceGroup(). Real device numbers do not have the highest bit set
+static constexpr uint64_t DEVICE_GROUP_FLAG = 1ull << 63;
+
 BufferedReaderManager::BufferedReaderManager(const uint32_t readersCnt, const uint32_t blockSize,
                                              const uint32_t allocSize, const uint32_t prereadThreshold)
+    : m_mmapReader(nullptr),
+      m_mmapInput(false),
+      m_readersCnt(std::max<uint32_t>(readersCnt, 1)),
+      m_readQueueDepth(0),
+      m_minReadAhead(0),
+      m_maxReadAhead(0),
+      m_dropInputCache(true)
 {
     init(blockSize, allocSize, prereadThreshold);
-
-    for (uint32_t i = 0; i < readersCnt; i++)
-    {
-        BufferedReader* reader = new BufferedFileReader(blockSize, allocSize, prereadThreshold);
-        reader->setId(i);
-        m_fileReaders.push_back(reader);
-    }
-
-    m_readersCnt = readersCnt;
 }
 
 void BufferedReaderManager::init(const uint32_t blockSize, const uint32_t allocSize, const uint32_t prereadThreshold)
@@ -26,6 +35,73 @@ void BufferedReaderManager::init(const uint32_t blockSize, const uint32_t allocS
     m_prereadThreshold = prereadThreshold > 0 ? prereadThreshold : m_blockSize / 2;
 }
 
+void BufferedReaderManager::setReadQueueDepth(const uint32_t queueDepth)
+{
+    std::lock_guard lock(m_readersMtx);
+    m_readQueueDepth = queueDepth;
+    for (const auto& reader : m_fileReaders) reader->setQueueDepth(queueDepth);
+}
+
+void BufferedReaderManager::setReadAhead(const uint32_t minBlocks, const uint32_t maxBlocks)
+{
+    std::lock_guard lock(m_readersMtx);
+    m_minReadAhead = minBlocks;
+    m_maxReadAhead = maxBlocks;
+    for (const auto& reader : m_fileReaders) reader->setReadAhead(minBlocks, maxBlocks);
+}
+
+int64_t BufferedReaderManager::getReadAheadSize() const
+{
+    // the current block and the blocks requested after it
+    return static_cast<int64_t>(std::max(DEFAULT_READ_AHEAD_BLOCKS, m_minReadAhead) + 1) * m_blockSize;
+}
+
+void BufferedReaderManager::setDropInputCache(const bool value)
+{
+    std::lock_guard lock(m_readersMtx);
+    m_dropInputCache = value;
+    for (const auto& reader : m_fileReaders) reader->setDropCache(value);
+}
+
+void BufferedReaderManager::setReadersPerDevice(const uint32_t readersCnt)
+{
+    std::lock_guard lock(m_readersMtx);
+    m_readersCnt = std::max<uint32_t>(readersCnt, 1);
+}
+
+void BufferedReaderManager::addDeviceGroup(const std::vector<std::string>& pathPrefixes)
+{
+    std::lock_guard lock(m_readersMtx);
+    const uint64_t device = DEVICE_GROUP_FLAG | m_deviceGroups.size();
+    for (const auto& prefix : pathPrefixes)
+        if (!prefix.empty())
+            m_deviceGroups.emplace_back(prefix, device);
+}
+
+bool BufferedReaderManager::setMmapInput(const bool value)
+{
+    if (value && !MmapFileReader::isSupported())
+        return false;
+    if (value && m_mmapReader == nullptr)
+        m_mmapReader = new MmapFileReader(m_blockSize, m_allocSize, m_prereadThreshold);
+    m_mmapInput = value;
+    return true;
+}
+
+ReadStats BufferedReaderManager::getReadStats() const
+{
+    std::lock_guard lock(m_readersMtx);
+    ReadStats rez;
+    for (const auto& reader : m_fileReaders)
+    {
+        const ReadStats stats = reader->getReadStats();
+        rez.stallCnt += stats.stallCnt;
+        rez.stallTime += stats.stallTime;
+        rez.maxBlockCnt = std::max(rez.maxBlockCnt, stats.maxBlockCnt);
+    }
+    return rez;
+}
+
 BufferedReaderManager::~BufferedReaderManager()
 {
     for (const auto& m_fileReader : m_fileReaders)
@@ -33,20 +109,59 @@ BufferedReaderManager::~BufferedReaderManager()
         delete m_fileReader;  // need to define destruction order first. This object MUST be deleted after
                               // MCVodStreamer
     }
+    delete m_mmapReader;
+}
+
+uint64_t BufferedReaderManager::deviceOf(const char* streamName) const
+{
+    for (const auto& [prefix, device] : m_deviceGroups)
+        if (strncmp(streamName, prefix.c_str(), prefix.size()) == 0)
+            return device;
+#ifndef _WIN32
+    struct stat st;
+    if (*streamName && stat(streamName, &st) == 0)
+        return static_cast<uint64_t>(st.st_dev) & ~DEVICE_GROUP_FLAG;
+#endif
+    return UNKNOWN_DEVICE;
+}
+
+BufferedReader* BufferedReaderManager::createFileReader() const
+{
+    BufferedReader* reader = new BufferedFileReader(m_blockSize, m_allocSize, m_prereadThreshold);
+    reader->setId(static_cast<uint32_t>(m_fileReaders.size()));
+    reader->setQueueDepth(m_readQueueDepth);
+    if (m_maxReadAhead)
+        reader->setReadAhead(m_minReadAhead, m_maxReadAhead);
+    reader->setDropCache(m_dropInputCache);
+    m_fileReaders.push_back(reader);
+    return reader;
 }
 
 AbstractReader* BufferedReaderManager::getReader(const char* streamName) const
 {
-    uint32_t minReaderCnt = UINT_MAX;
-    uint32_t minReaderIndex = 0;
+    // a pipe can't be mapped into memory
+    if (m_mmapInput && !isPipeInput(streamName))
+        return m_mmapReader;
+
+    std::lock_guard lock(m_readersMtx);
+    std::vector<BufferedReader*>& readers = m_deviceReaders[deviceOf(streamName)];
 
-    for (uint32_t i = 0; i < m_readersCnt; i++)
+    uint32_t minReaderCnt = UINT_MAX;
+    BufferedReader* minReader = nullptr;
+    for (const auto& reader : readers)
     {
-        if (m_fileReaders[i]->getReaderCount() < minReaderCnt)
+        const uint32_t readerCnt = reader->getReaderCount();
+        if (readerCnt < minReaderCnt)
         {
-            minReaderCnt = m_fileReaders[i]->getReaderCount();
-            minReaderIndex = i;
+            minReaderCnt = readerCnt;
+            minReader = reader;
         }
     }
-    return m_fileReaders[minReaderIndex];
+    // start one more thread for the device if all of them are busy
+    if (minReader == nullptr || (minReaderCnt > 0 && readers.size() < m_readersCnt))
+    {
+        minReader = createFileReader();
+        readers.push_back(minReader);
+    }
+    return minReader;
 }
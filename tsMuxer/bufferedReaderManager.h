@@ -1,10 +1,16 @@
 #ifndef BUFFERED_READER_MANAGER_H_
 #define BUFFERED_READER_MANAGER_H_
 
+#include <map>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include "bufferedFileReader.h"
+#include "mmapFileReader.h"
 
+// Streams are read by reader threads grouped by the device the files are stored on, so a slow device does not delay
+// the reads from the others. Up to readersCnt threads are started per device, when they are needed.
 class BufferedReaderManager
 {
    public:
@@ -12,16 +18,45 @@ class BufferedReaderManager
                           uint32_t prereadThreshold = 0);
     ~BufferedReaderManager();
     AbstractReader* getReader(const char* streamName) const;
+    // Maximum number of reader threads per device
+    void setReadersPerDevice(uint32_t readersCnt);
+    // Read the files which names start with any of the given prefixes as if they were stored on the same device
+    void addDeviceGroup(const std::vector<std::string>& pathPrefixes);
 
     void init(uint32_t blockSize = 0, uint32_t allocSize = 0, uint32_t prereadThreshold = 0);
+    // Number of reads kept in flight by each reader thread. 0 - use blocking reads
+    void setReadQueueDepth(uint32_t queueDepth);
+    // Per-stream read-ahead ring size. The ring grows from minBlocks up to maxBlocks while the demuxer stalls
+    void setReadAhead(uint32_t minBlocks, uint32_t maxBlocks);
+    [[nodiscard]] ReadStats getReadStats() const;
+    // Read local files through memory mapping instead of the reader threads. Returns false if it is not supported
+    bool setMmapInput(bool value);
+    // Drop the input files from the OS page cache once they are read (enabled by default). Should be disabled if the
+    // same files are read again soon, e.g. when the streams are detected before muxing
+    void setDropInputCache(bool value);
 
     [[nodiscard]] uint32_t getBlockSize() const { return m_blockSize; }
     [[nodiscard]] uint32_t getAllocSize() const { return m_allocSize; }
     [[nodiscard]] uint32_t getPreReadThreshold() const { return m_prereadThreshold; }
+    // The data of a stream which is read before the demuxer needs it. Seeking a shorter distance saves no reads
+    [[nodiscard]] int64_t getReadAheadSize() const;
 
    private:
-    std::vector<BufferedReader*> m_fileReaders;
+    uint64_t deviceOf(const char* streamName) const;
+    BufferedReader* createFileReader() const;
+
+    mutable std::mutex m_readersMtx;
+    mutable std::vector<BufferedReader*> m_fileReaders;
+    mutable std::map<uint64_t, std::vector<BufferedReader*>> m_deviceReaders;
+    std::vector<std::pair<std::string, uint64_t>> m_deviceGroups;  // path prefix, device group
+    MmapFileReader* m_mmapReader;
+    bool m_mmapInput;
     uint32_t m_readersCnt;
+    // settings of the reader threads, also applied to the threads started later
+    uint32_t m_readQueueDepth;
+    uint32_t m_minReadAhead;
+    uint32_t m_maxReadAhead;
+    bool m_dropInputCache;
     uint32_t m_blockSize;
     uint32_t m_allocSize;
     uint32_t m_prereadThreshold;
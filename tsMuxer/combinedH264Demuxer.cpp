@@ -236,10 +236,7 @@ int64_t CombinedH264Demuxer::getDemuxedSize() { return m_dataProcessed; }
 
 void CombinedH264Demuxer::setFileIterator(FileNameIterator* itr)
 {
-    const auto br = dynamic_cast<BufferedFileReader*>(m_bufferedReader);
-    if (br)
-        br->setFileIterator(itr, m_readerID);
-    else if (itr != nullptr)
+    if (!m_bufferedReader->setFileIterator(itr, m_readerID) && itr != nullptr)
         THROW(ERR_COMMON, "Can not set file iterator. Reader does not support bufferedReader interface.")
 }
 
@@ -1,6 +1,7 @@
 #include "ioContextDemuxer.h"
 
 #include <types/types.h>
+#include <cassert>
 #include <cmath>
 
 #include "abstractStreamReader.h"
@@ -13,6 +14,61 @@ using namespace std;
 #endif
 /////////////////////////////////////
 
+namespace
+{
+// the buffer is enlarged by a quarter more than needed, so a slowly growing unit size does not realloc each time
+constexpr size_t ARENA_GROWTH_DIVIDER = 4;
+
+// the value of the bytes in big-endian and little-endian order. The loops of constant length become single loads
+uint64_t loadBE(const uint8_t* data, const int bytes)
+{
+    uint64_t rez = 0;
+    for (int i = 0; i < bytes; ++i) rez = rez << 8 | data[i];
+    return rez;
+}
+
+uint64_t loadLE(const uint8_t* data, const int bytes)
+{
+    uint64_t rez = 0;
+    for (int i = bytes - 1; i >= 0; --i) rez = rez << 8 | data[i];
+    return rez;
+}
+}  // namespace
+
+uint8_t* PacketArena::alloc(const size_t size)
+{
+    if (size <= m_capacity - m_used)
+    {
+        uint8_t* rez = m_buffer.get() + m_used;
+        m_used += size;
+        return rez;
+    }
+    m_overflow.emplace_back(new uint8_t[size]);
+    m_overflowSize += size;
+    return m_overflow.back().get();
+}
+
+void PacketArena::reset()
+{
+    if (m_overflowSize > 0)
+    {
+        m_capacity = m_used + m_overflowSize;
+        m_capacity += m_capacity / ARENA_GROWTH_DIVIDER;
+        m_buffer.reset(new uint8_t[m_capacity]);
+        m_overflow.clear();
+        m_overflowSize = 0;
+    }
+    m_used = 0;
+}
+
+uint8_t* ParsedTrackPrivData::allocPacketData(AVPacket* pkt, const int size) const
+{
+    assert(m_packetArena != nullptr);
+    pkt->size = size;
+    pkt->data = m_packetArena->alloc(size);
+    return pkt->data;
+}
+
 double av_int2dbl(const uint64_t v)
 {
     if (v + v > 0xFFEULL << 52)
@@ -29,11 +85,11 @@ float av_int2flt(const uint32_t v)
                  static_cast<int>(v >> 23 & 0xFF) - 150);
 }
 
-IOContextDemuxer::IOContextDemuxer(const BufferedReaderManager& readManager)
+IOContextDemuxer::IOContextDemuxer(const BufferedReaderManager& readManager, const char* streamName)
     : tracks(), m_readManager(readManager), m_lastReadRez(0)
 {
     m_lastProcessedBytes = 0;
-    m_bufferedReader = m_readManager.getReader("");
+    m_bufferedReader = m_readManager.getReader(streamName);
     m_readerID = m_bufferedReader->createReader(TS_FRAME_SIZE);
     m_curPos = m_bufEnd = nullptr;
     m_processedBytes = 0;
@@ -43,42 +99,58 @@ IOContextDemuxer::IOContextDemuxer(const BufferedReaderManager& readManager)
 
 IOContextDemuxer::~IOContextDemuxer() { m_bufferedReader->deleteReader(m_readerID); }
 
-int IOContextDemuxer::get_byte()
+bool IOContextDemuxer::fillBuffer()
 {
     uint32_t readedBytes = 0;
     int readRez = 0;
+    uint8_t* data = m_bufferedReader->readBlock(m_readerID, readedBytes, readRez);  // blocked read mode
+    if (readedBytes > 0 && readRez == 0)
+        m_bufferedReader->notify(m_readerID, readedBytes);
+    m_lastReadRez = readRez;
+    m_curPos = data + 188;
+    m_bufEnd = m_curPos + readedBytes;
     if (m_curPos == m_bufEnd)
     {
-        uint8_t* data = m_bufferedReader->readBlock(m_readerID, readedBytes, readRez);  // blocked read mode
-        if (readedBytes > 0 && readRez == 0)
-            m_bufferedReader->notify(m_readerID, readedBytes);
-        m_lastReadRez = readRez;
-        m_curPos = data + 188;
-        m_bufEnd = m_curPos + readedBytes;
-        if (m_curPos == m_bufEnd)
-        {
-            m_isEOF = true;
-            return 0;
-        }
+        m_isEOF = true;
+        return false;
     }
-    m_processedBytes++;
-    return *m_curPos++;
+    return true;
 }
 
-uint16_t IOContextDemuxer::get_be16() { return static_cast<uint16_t>(get_byte() << 8 | get_byte()); }
+uint16_t IOContextDemuxer::get_be16()
+{
+    if (const uint8_t* data = takeBuffered(2))
+        return static_cast<uint16_t>(loadBE(data, 2));
+    return static_cast<uint16_t>(get_byte() << 8 | get_byte());
+}
 
-int IOContextDemuxer::get_be24() { return get_be16() << 8 | get_byte(); }
+int IOContextDemuxer::get_be24()
+{
+    if (const uint8_t* data = takeBuffered(3))
+        return static_cast<int>(loadBE(data, 3));
+    return get_be16() << 8 | get_byte();
+}
 
-unsigned int IOContextDemuxer::get_be32() { return get_be16() << 16 | get_be16(); }
+unsigned int IOContextDemuxer::get_be32()
+{
+    if (const uint8_t* data = takeBuffered(4))
+        return static_cast<unsigned>(loadBE(data, 4));
+    return get_be16() << 16 | get_be16();
+}
 
-int64_t IOContextDemuxer::get_be64() { return static_cast<int64_t>(get_be32()) << 32 | get_be32(); }
+int64_t IOContextDemuxer::get_be64()
+{
+    if (const uint8_t* data = takeBuffered(8))
+        return static_cast<int64_t>(loadBE(data, 8));
+    return static_cast<int64_t>(get_be32()) << 32 | get_be32();
+}
 
 bool IOContextDemuxer::url_fseek(const int64_t offset)
 {
     m_curPos = m_bufEnd = nullptr;
     m_isEOF = false;
     m_processedBytes = offset;
-    return dynamic_cast<BufferedFileReader*>(m_bufferedReader)->gotoByte(m_readerID, offset);
+    return m_bufferedReader->gotoByte(m_readerID, offset);
 }
 
 unsigned IOContextDemuxer::get_buffer(uint8_t* binary, unsigned size)
@@ -159,10 +231,7 @@ void IOContextDemuxer::skip_bytes(const int64_t size)
 
 void IOContextDemuxer::setFileIterator(FileNameIterator* itr)
 {
-    const auto br = dynamic_cast<BufferedReader*>(m_bufferedReader);
-    if (br)
-        br->setFileIterator(itr, m_readerID);
-    else if (itr != nullptr)
+    if (!m_bufferedReader->setFileIterator(itr, m_readerID) && itr != nullptr)
         THROW(ERR_COMMON, "Can not set file iterator. Reader does not support bufferedReader interface.")
 }
 
@@ -170,6 +239,8 @@ int64_t IOContextDemuxer::getDemuxedSize() { return 0; }
 
 unsigned int IOContextDemuxer::get_le16()
 {
+    if (const uint8_t* data = takeBuffered(2))
+        return static_cast<unsigned>(loadLE(data, 2));
     unsigned int val = get_byte();
     val |= get_byte() << 8;
     return val;
@@ -177,6 +248,8 @@ unsigned int IOContextDemuxer::get_le16()
 
 unsigned int IOContextDemuxer::get_le24()
 {
+    if (const uint8_t* data = takeBuffered(3))
+        return static_cast<unsigned>(loadLE(data, 3));
     unsigned int val = get_le16();
     val |= get_byte() << 16;
     return val;
@@ -184,6 +257,8 @@ unsigned int IOContextDemuxer::get_le24()
 
 unsigned int IOContextDemuxer::get_le32()
 {
+    if (const uint8_t* data = takeBuffered(4))
+        return static_cast<unsigned>(loadLE(data, 4));
     unsigned int val = get_le16();
     val |= get_le16() << 16;
     return val;
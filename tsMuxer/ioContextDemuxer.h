@@ -1,6 +1,7 @@
 #ifndef IO_CONTEXT_DEMUXER_H_
 #define IO_CONTEXT_DEMUXER_H_
 
+#include <memory>
 #include <vector>
 
 #include "abstractDemuxer.h"
@@ -12,6 +13,28 @@ static constexpr int TRACKTYPE_PGS = 0x090;
 static constexpr int TRACKTYPE_SRT = 0x190;
 static constexpr int TRACKTYPE_WAV = 0x180;
 
+//! Storage of the packets of one container unit which is released at once
+/*!
+        The data is taken from one buffer which is kept between the units, so a steady stream of units of similar size
+        does not allocate memory. The buffer grows on reset() if the previous unit did not fit in it.
+*/
+class PacketArena
+{
+   public:
+    PacketArena() : m_capacity(0), m_used(0), m_overflowSize(0) {}
+
+    uint8_t* alloc(size_t size);
+    //! Release all the data. The pointers returned by alloc() are not valid after that
+    void reset();
+
+   private:
+    std::unique_ptr<uint8_t[]> m_buffer;
+    size_t m_capacity;
+    size_t m_used;
+    std::vector<std::unique_ptr<uint8_t[]>> m_overflow;  // the allocations which did not fit in the buffer
+    size_t m_overflowSize;
+};
+
 class ParsedTrackPrivData
 {
    public:
@@ -22,6 +45,14 @@ class ParsedTrackPrivData
     virtual void setPrivData(uint8_t* buff, int size) {}
     virtual void extractData(AVPacket* pkt, uint8_t* buff, int size) = 0;
     virtual unsigned newBufferSize(uint8_t* buff, unsigned size) { return 0; }
+    //! Set the storage of the data allocated by extractData()
+    void setPacketArena(PacketArena* arena) { m_packetArena = arena; }
+
+   protected:
+    //! Allocate the data of the packet in the storage of the demuxer
+    uint8_t* allocPacketData(AVPacket* pkt, int size) const;
+
+    PacketArena* m_packetArena = nullptr;
 };
 
 enum class IOContextTrackType
@@ -87,7 +118,7 @@ struct Track
 class IOContextDemuxer : public AbstractDemuxer
 {
    public:
-    IOContextDemuxer(const BufferedReaderManager& readManager);
+    IOContextDemuxer(const BufferedReaderManager& readManager, const char* streamName);
     ~IOContextDemuxer() override;
     void setFileIterator(FileNameIterator* itr) override;
     int64_t getDemuxedSize() override;
@@ -116,11 +147,37 @@ class IOContextDemuxer : public AbstractDemuxer
     unsigned int get_be32();
     uint16_t get_be16();
     int get_be24();
-    int get_byte();
+    int get_byte()
+    {
+        if (m_curPos == m_bufEnd && !fillBuffer())
+            return 0;
+        m_processedBytes++;
+        return *m_curPos++;
+    }
 
     unsigned int get_le16();
     unsigned int get_le24();
     unsigned int get_le32();
+
+    //! The number of the bytes which can be read at m_curPos without reading the next block
+    [[nodiscard]] unsigned bufferedBytes() const { return static_cast<unsigned>(m_bufEnd - m_curPos); }
+    //! Take the next size bytes from the current block
+    /*!
+            Returns nullptr and keeps the position if the bytes cross the end of the block, so the caller falls back
+            to get_byte().
+    */
+    const uint8_t* takeBuffered(const unsigned size)
+    {
+        if (bufferedBytes() < size)
+            return nullptr;
+        const uint8_t* rez = m_curPos;
+        m_curPos += size;
+        m_processedBytes += size;
+        return rez;
+    }
+
+   private:
+    bool fillBuffer();
 };
 
 #endif
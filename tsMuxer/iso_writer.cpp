@@ -325,7 +325,7 @@ FileEntryInfo::FileEntryInfo(IsoWriter *owner, FileEntryInfo *parent, const uint
       m_subMode(false)
 {
     if (isFile())
-        m_sectorBuffer = new uint8_t[SECTOR_SIZE];
+        m_sectorBuffer = allocIoBuffer(SECTOR_SIZE);
     else
         m_sectorBuffer = nullptr;
 }
@@ -334,7 +334,7 @@ bool FileEntryInfo::isFile() const { return m_fileType == FileTypes::File || m_f
 
 FileEntryInfo::~FileEntryInfo()
 {
-    delete[] m_sectorBuffer;
+    freeIoBuffer(m_sectorBuffer);
     for (const auto &m_file : m_files) delete m_file;
     for (const auto &m_subDir : m_subDirs) delete m_subDir;
 }
@@ -445,11 +445,11 @@ void FileEntryInfo::addExtent(const Extent &extent)
     m_fileSize += extent.size;
 }
 
-int32_t FileEntryInfo::write(const uint8_t *data, const int32_t len)
+void FileEntryInfo::addWrittenData(const int32_t len, const int32_t sectorNum)
 {
     if (m_owner->m_lastWritedObjectID != m_objectId)
     {
-        m_extents.emplace_back(m_owner->absoluteSectorNum(), len);
+        m_extents.emplace_back(sectorNum, len);
     }
     else
     {
@@ -458,11 +458,16 @@ int32_t FileEntryInfo::write(const uint8_t *data, const int32_t len)
         else
         {
             assert(m_extents.rbegin()->size % SECTOR_SIZE == 0);
-            m_extents.emplace_back(m_owner->absoluteSectorNum(), len);
+            m_extents.emplace_back(sectorNum, len);
         }
     }
     m_owner->m_lastWritedObjectID = m_objectId;
     m_fileSize += len;
+}
+
+int32_t FileEntryInfo::write(const uint8_t *data, const int32_t len)
+{
+    addWrittenData(len, m_owner->absoluteSectorNum());
     int32_t writeLen = len;
 
     if (m_sectorBufferSize)
@@ -472,7 +477,8 @@ int32_t FileEntryInfo::write(const uint8_t *data, const int32_t len)
         m_sectorBufferSize += toCopy;
         if (m_sectorBufferSize == SECTOR_SIZE)
         {
-            m_owner->writeRawData(m_sectorBuffer, SECTOR_SIZE);
+            if (m_owner->writeRawData(m_sectorBuffer, SECTOR_SIZE) != SECTOR_SIZE)
+                return 0;
             m_sectorBufferSize = 0;
             data += toCopy;
             writeLen -= toCopy;
@@ -484,7 +490,11 @@ int32_t FileEntryInfo::write(const uint8_t *data, const int32_t len)
     }
     const int dataRest = writeLen % SECTOR_SIZE;
     if (writeLen - dataRest > 0)
-        m_owner->writeRawData(data, writeLen - dataRest);
+    {
+        const int written = m_owner->writeRawData(data, writeLen - dataRest);
+        if (written != writeLen - dataRest)
+            return len - writeLen + FFMAX(written, 0);
+    }
     if (dataRest)
     {
         memcpy(m_sectorBuffer, data + writeLen - dataRest, dataRest);
@@ -494,16 +504,56 @@ int32_t FileEntryInfo::write(const uint8_t *data, const int32_t len)
     return len;
 }
 
-void FileEntryInfo::close()
+int64_t FileEntryInfo::writev(const IoSlice *slices, const int count)
+{
+    // whole sectors are written with one call. Data which goes through the sector buffer is written by write()
+    std::vector<IoSlice> batch;
+    int64_t batchSize = 0;
+    int64_t total = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const auto len = static_cast<int32_t>(slices[i].size);
+        if (m_sectorBufferSize == 0 && len % SECTOR_SIZE == 0)
+        {
+            addWrittenData(len, m_owner->absoluteSectorNum() + static_cast<int32_t>(batchSize / SECTOR_SIZE));
+            batch.push_back(slices[i]);
+            batchSize += len;
+            continue;
+        }
+        if (!batch.empty())
+        {
+            const int64_t written = m_owner->writeRawData(batch.data(), static_cast<int>(batch.size()));
+            if (written != batchSize)
+                return total + FFMAX(written, 0);
+            batch.clear();
+            total += batchSize;
+            batchSize = 0;
+        }
+        const int32_t written = write(static_cast<const uint8_t *>(slices[i].data), len);
+        if (written != len)
+            return total + FFMAX(written, 0);
+        total += len;
+    }
+    if (!batch.empty())
+    {
+        const int64_t written = m_owner->writeRawData(batch.data(), static_cast<int>(batch.size()));
+        if (written != batchSize)
+            return total + FFMAX(written, 0);
+    }
+    return total + batchSize;
+}
+
+bool FileEntryInfo::close()
 {
     if (m_sectorBufferSize)
     {
         const auto delta = static_cast<int>(m_fileSize / SECTOR_SIZE);
         m_owner->sectorSeek(IsoWriter::Partition::MainPartition, m_extents.rbegin()->lbnPos + delta);
         memset(m_sectorBuffer + m_sectorBufferSize, 0, SECTOR_SIZE - m_sectorBufferSize);
-        m_owner->writeRawData(m_sectorBuffer, SECTOR_SIZE);
         m_sectorBufferSize = 0;
+        return m_owner->writeRawData(m_sectorBuffer, SECTOR_SIZE) == SECTOR_SIZE;
     }
+    return true;
 }
 
 void FileEntryInfo::setSubMode(const bool value) { m_subMode = value; }
@@ -537,6 +587,13 @@ int ISOFile::write(const void *data, const uint32_t len)
     return -1;
 }
 
+int64_t ISOFile::writev(const IoSlice *slices, const int count)
+{
+    if (m_entry)
+        return m_entry->writev(slices, count);
+    return -1;
+}
+
 bool ISOFile::open(const char *name, unsigned int oflag, unsigned int systemDependentFlags)
 {
     FileTypes fileType = FileTypes::File;
@@ -548,12 +605,13 @@ bool ISOFile::open(const char *name, unsigned int oflag, unsigned int systemDepe
 
 void ISOFile::sync() { m_owner->m_file.sync(); }
 
+void ISOFile::setWriteback(const uint32_t windowSize) { m_owner->m_file.setWriteback(windowSize); }
+
 bool ISOFile::close()
 {
-    if (m_entry)
-        m_entry->close();
+    const bool rez = m_entry == nullptr || m_entry->close();
     m_entry = nullptr;
-    return true;
+    return rez;
 }
 
 void ISOFile::setSubMode(const bool value) const
@@ -612,10 +670,10 @@ void IsoWriter::setVolumeLabel(const std::string &value)
         m_volumeLabel = "Blu-Ray";
 }
 
-bool IsoWriter::open(const std::string &fileName, const int64_t diskSize, const int extraISOBlocks)
+bool IsoWriter::open(const std::string &fileName, const int64_t diskSize, const int extraISOBlocks, const bool directIo)
 {
     constexpr int systemFlags = 0;
-    if (!m_file.open(fileName.c_str(), File::ofWrite, systemFlags))
+    if (!m_file.open(fileName.c_str(), directIo ? File::ofWrite + File::ofDirect : File::ofWrite, systemFlags))
         return false;
 
     if (diskSize > 0)
@@ -857,7 +915,15 @@ void IsoWriter::close()
         return;
 
     memset(m_buffer, 0, sizeof(m_buffer));
-    while (m_file.size() % ALLOC_BLOCK_SIZE != 1024LL * 62) m_file.write(m_buffer, SECTOR_SIZE);
+    while (m_file.size() % ALLOC_BLOCK_SIZE != 1024LL * 62)
+    {
+        // the output is full, the file never reaches the padded size
+        if (m_file.write(m_buffer, SECTOR_SIZE) != SECTOR_SIZE)
+        {
+            m_opened = false;
+            return;
+        }
+    }
 
     // mirror metadata file location and length
     m_metadataMirrorLBN = static_cast<int>(m_file.size() / SECTOR_SIZE + 1);
@@ -1404,6 +1470,8 @@ void IsoWriter::writeSector(const uint8_t *sectorData) { m_file.write(sectorData
 
 int IsoWriter::writeRawData(const uint8_t *data, const int size) { return m_file.write(data, size); }
 
+int64_t IsoWriter::writeRawData(const IoSlice *slices, const int count) { return m_file.writev(slices, count); }
+
 void IsoWriter::checkLayerBreakPoint(const int maxExtentSize)
 {
     const int lbn = absoluteSectorNum();
@@ -127,8 +127,9 @@ struct FileEntryInfo
     ~FileEntryInfo();
 
     int32_t write(const uint8_t* data, int32_t len);
+    int64_t writev(const IoSlice* slices, int count);
     bool setName(const std::string& name);
-    void close();
+    bool close();
     void setSubMode(bool value);
     void addExtent(const Extent& extent);
 
@@ -136,6 +137,7 @@ struct FileEntryInfo
     [[nodiscard]] FileEntryInfo* fileByName(const std::string& name) const;
 
    private:
+    void addWrittenData(int32_t len, int32_t sectorNum);
     void addSubDir(FileEntryInfo* dir);
     void addFile(FileEntryInfo* file);
     void serialize() const;  // flush directory tree to a disk
@@ -183,7 +185,7 @@ class IsoWriter
     ~IsoWriter();
 
     void setVolumeLabel(const std::string& value);
-    bool open(const std::string& fileName, int64_t diskSize, int extraISOBlocks);
+    bool open(const std::string& fileName, int64_t diskSize, int extraISOBlocks, bool directIo = false);
 
     bool createDir(const std::string& dir);
     ISOFile* createFile();
@@ -203,6 +205,7 @@ class IsoWriter
 
     void setMetaPartitionSize(int size);
     int writeRawData(const uint8_t* data, int size);
+    int64_t writeRawData(const IoSlice* slices, int count);
     void checkLayerBreakPoint(int maxExtentSize);
     void writePrimaryVolumeDescriptor();
     void writeAnchorVolumeDescriptor(uint32_t endPartitionAddr);
@@ -242,7 +245,7 @@ class IsoWriter
     std::string m_appId;
     uint32_t m_volumeId;
     File m_file;
-    uint8_t m_buffer[SECTOR_SIZE];
+    alignas(IO_BUFFER_ALIGNMENT) uint8_t m_buffer[SECTOR_SIZE];
     time_t m_currentTime;
 
     uint8_t m_objectUniqId;
@@ -278,8 +281,10 @@ class ISOFile final : public AbstractOutputStream
     ~ISOFile() override { close(); }
 
     int write(const void* data, uint32_t len) override;
+    int64_t writev(const IoSlice* slices, int count) override;
     bool open(const char* name, unsigned int oflag, unsigned int systemDependentFlags = 0) override;
     void sync() override;
+    void setWriteback(uint32_t windowSize) override;
     bool close() override;
     [[nodiscard]] int64_t size() const override;
     void setSubMode(bool value) const;
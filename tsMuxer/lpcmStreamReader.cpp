@@ -921,3 +921,10 @@ void LPCMStreamReader::setBuffer(uint8_t* data, const uint32_t dataLen, const bo
     m_lastChannelRemapPos = nullptr;
     SimplePacketizerReader::setBuffer(data, dataLen, lastBlock);
 }
+
+void LPCMStreamReader::setBufferSlices(const std::vector<DataSlice>& slices, const uint32_t dataLen,
+                                       const bool lastBlock)
+{
+    m_lastChannelRemapPos = nullptr;
+    SimplePacketizerReader::setBufferSlices(slices, dataLen, lastBlock);
+}
@@ -55,6 +55,7 @@ class LPCMStreamReader final : public SimplePacketizerReader
     int flushPacket(AVPacket& avPacket) override;
     void onSplitEvent() override { m_firstFrame = true; }
     void setBuffer(uint8_t* data, uint32_t dataLen, bool lastBlock = false) override;
+    void setBufferSlices(const std::vector<DataSlice>& slices, uint32_t dataLen, bool lastBlock = false) override;
 
    private:
     LPCMHeaderType m_headerType;
@@ -14,6 +14,7 @@
 #include "mpegStreamReader.h"
 #include "muxerManager.h"
 #include "pgsStreamReader.h"
+#include "probeCache.h"
 #include "singleFileMuxer.h"
 #include "tsMuxer.h"
 
@@ -339,6 +340,14 @@ tsMuxeR can be run in track detection mode or muxing mode. If tsMuxeR is run
 with only one argument, then the program displays track information required to
 construct a meta file. When running with two arguments, tsMuxeR starts the
 muxing or demuxing process.
+If the output name is "-", a TS stream is written to stdout and the messages
+are written to stderr.
+An input file name can be a named pipe, or "-" for an elementary stream read
+from stdin.
+The detected tracks are cached in the user's cache directory, so a file which
+did not change is not parsed again. Run "tsMuxeR --probe-cache=refresh <media
+file name>" to detect the tracks again, or "--probe-cache=off" to bypass the
+cache.
 
 Meta file format:
 File MUST have the .meta extension and be encoded in UTF-8 (but see README.md).
@@ -519,7 +528,10 @@ All parameters in this group start with two dashes:
 --avchd               Mux to AVCHD disc.
 --cut-start           Trim the beginning of the file. The value should be followed
                       by the time unit : "ms" (milliseconds), "s" (seconds) or
-                      "min" (minutes).
+                      "min" (minutes). MKV and MP4/MOV inputs with an index are
+                      read from the key frame preceding the cut. TS and M2TS
+                      inputs and playlists are read from the key frame found by
+                      the Blu-ray clip info or by the PCR.
 --cut-end             Trim the end of the file. Same rules as --cut-start apply.
 --split-duration      Split the output into several files, with each of them being
                       <n> seconds long.
@@ -541,6 +553,39 @@ All parameters in this group start with two dashes:
                       of small files, it may be required to define extra space.
 --constant-iso-hdr    Generates an ISO header that does not depend on the program
                       version or the current time. Not meant for normal usage.
+--read-ahead          Number of blocks read ahead per input stream, either as
+                      <max> or as <min>:<max>. The read-ahead grows from <min>
+                      (2 by default) up to <max> (4 by default) blocks each
+                      time the demuxer has to wait for the input.
+--read-stats          Print how often and how long muxing waited for the input.
+--write-batch         Write up to <n> queued output blocks of a file with one
+                      system call (8 by default). 1 disables batching.
+--writer-threads      Maximum number of threads writing the output files (4 by
+                      default). Files on different devices are written by
+                      different threads.
+--writer-per-file     Use a writer thread per output file instead of per device.
+--write-stats         Print how often and how long muxing waited for the output
+                      files to be written, and the largest write queue.
+--io-uring            Read the input files asynchronously via io_uring, keeping
+                      <n> reads in flight (32 by default). Linux only. Blocking
+                      reads are used if io_uring is not available.
+--direct-io           Write the output files with O_DIRECT, bypassing the OS page
+                      cache. The end of a file, which is not a whole number of
+                      sectors, is written through the cache. Not available on
+                      Windows.
+--writeback           Start the writeback of the output files every <n> MiB
+                      and drop the written data from the OS page cache, so
+                      the amount of dirty memory stays bounded. Linux only.
+--readers-per-device  Maximum number of reader threads per storage device (2 by
+                      default). The input files are read by separate threads
+                      for each device they are stored on.
+--same-device         Comma separated list of paths which input files are read
+                      as if they were on the same device, e.g. the mount points
+                      of one network server. Can be used several times.
+--keep-input-cache    Keep the input files in the OS page cache. By default they
+                      are dropped from it once they are read. Linux only.
+--mmap                Read local input files through memory mapping instead of
+                      copying them into read buffers. Not available on Windows.
 )help";
     LTRACE(LT_INFO, 2, help);
 }
@@ -568,6 +613,26 @@ int main(int argc, char** argv)
     }
     argv = argv_vec.data();
 #endif
+    // tsMuxeR --probe-cache=<mode> <media file name>
+    if (argc == 3 && strStartWith(argv[1], "--probe-cache="))
+    {
+        const string mode = argv[1] + strlen("--probe-cache=");
+        if (mode == "refresh")
+            ProbeCache::setMode(ProbeCache::Mode::pcmRefresh);
+        else if (mode == "off")
+            ProbeCache::setMode(ProbeCache::Mode::pcmOff);
+        else if (mode != "on")
+        {
+            cerr << "Unknown probe cache mode: " << mode << endl;
+            return -1;
+        }
+        argv[1] = argv[2];
+        argc = 2;
+    }
+    // TS stream written to stdout, e.g. to pipe it to another program. Keep the messages out of it
+    const bool toStdout = argc == 3 && unquoteStr(argv[2]) == STDOUT_FILE_NAME;
+    if (toStdout)
+        cout.rdbuf(cerr.rdbuf());
     LTRACE(LT_INFO, 2, "tsMuxeR version " TSMUXER_VERSION << ". github.com/justdan96/tsMuxer");
     int firstMplsOffset = 0;
     int firstM2tsOffset = 0;
@@ -592,6 +657,8 @@ int main(int argc, char** argv)
     {
         if (argc == 2)
         {
+            // the detected files are usually muxed right after that, keep them in the page cache
+            readManager.setDropInputCache(false);
             string str = argv[1];
             string fileExt = extractFileExt(str);
             fileExt = strToLowerCase(fileExt);
@@ -713,8 +780,10 @@ int main(int argc, char** argv)
         DiskType dt = checkBluRayMux(argv[1], autoChapterLen, customChapterList, firstMplsOffset, firstM2tsOffset,
                                      insertBlankPL, blankNum, stereoMode, isoDiskLabel);
         std::string fileExt2 = unquoteStr(fileExt);
-        bool muxMode =
-            fileExt2 == "M2TS" || fileExt2 == "TS" || fileExt2 == "SSIF" || fileExt2 == "ISO" || dt != DiskType::NONE;
+        if (toStdout && dt != DiskType::NONE)
+            THROW(ERR_COMMON, "Blu-ray and AVCHD output can't be written to stdout")
+        bool muxMode = fileExt2 == "M2TS" || fileExt2 == "TS" || fileExt2 == "SSIF" || fileExt2 == "ISO" ||
+                       dt != DiskType::NONE || toStdout;
 
         if (muxMode)
         {
@@ -738,7 +807,7 @@ int main(int argc, char** argv)
             if (dt != DiskType::NONE)
             {
                 if (!blurayHelper.open(dstFile, dt, muxerManager.totalSize(), muxerManager.getExtraISOBlocks(),
-                                       muxerManager.useReproducibleIsoHeader()))
+                                       muxerManager.useReproducibleIsoHeader(), muxerManager.useDirectIo()))
                     throw runtime_error(string("Can't create output file ") + dstFile);
                 blurayHelper.setVolumeLabel(isoDiskLabel);
                 blurayHelper.createBluRayDirs();
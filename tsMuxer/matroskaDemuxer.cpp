@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <climits>
+#include <cmath>
 
 #include <fs/systemlog.h>
 #include <types/types.h>
@@ -26,6 +27,11 @@ static constexpr int AVERROR_INVALIDDATA = -1;
 static constexpr int COMPRESSION_STRIP_HEADERS = 3;
 static constexpr int COMPRESSION_ZLIB = 0;
 
+// the data read from a cue point to find the first frames of the tracks
+static constexpr int64_t MAX_SEEK_SCAN_SIZE = 64 * 1024 * 1024;
+// the earlier cue points tried if the tracks start after the seek time at a cue point
+static constexpr int MAX_CUE_POINT_TRIES = 8;
+
 #define AV_RL32(x) ((x)[3] << 24 | (x)[2] << 16 | (x)[1] << 8 | (x)[0])
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
@@ -187,8 +193,8 @@ int MatroskaDemuxer::matroska_parse_index()
     return res;
 }
 
-MatroskaDemuxer::MatroskaDemuxer(const BufferedReaderManager &readManager)
-    : IOContextDemuxer(readManager), levels(), m_title(), created(0), fileDuration(0)
+MatroskaDemuxer::MatroskaDemuxer(const BufferedReaderManager &readManager, const char *streamName)
+    : IOContextDemuxer(readManager, streamName), levels(), m_title(), created(0), fileDuration(0)
 {
     m_lastDeliveryPacket = nullptr;
     num_levels = 0;
@@ -201,6 +207,8 @@ MatroskaDemuxer::MatroskaDemuxer(const BufferedReaderManager &readManager)
     m_firstTimecode.clear();
     index_parsed = false;
     metadata_parsed = false;
+    m_seekHeadPos = -1;
+    m_scanBlocks = false;
     writing_app = nullptr;
     muxing_app = nullptr;
 }
@@ -339,7 +347,7 @@ int MatroskaDemuxer::ebml_read_header(char **doctype, int *version)
     return 0;
 }
 
-void MatroskaDemuxer::matroska_queue_packet(AVPacket *pkt) { packets.push(pkt); }
+void MatroskaDemuxer::matroska_queue_packet(AVPacket *pkt) { packets.push_back(pkt); }
 
 int MatroskaDemuxer::rv_offset(const uint8_t *data, const int slice, const int slices)
 {
@@ -420,7 +428,7 @@ int MatroskaDemuxer::matroska_deliver_packet(AVPacket *&avPacket)
     if (!packets.empty())
     {
         avPacket = packets.front();
-        packets.pop();
+        packets.pop_front();
         return 0;
     }
 
@@ -486,7 +494,6 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
 {
     int res = 0;
     // AVStream *st;
-    const uint8_t *origdata = data;
     int *lace_size = nullptr;
     int n, laces = 0;
     uint64_t num;
@@ -495,7 +502,6 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
     if ((n = matroska_ebmlnum_uint(data, size, &num)) < 0)
     {
         LTRACE(LT_ERROR, 0, "EBML block data error");
-        delete[] origdata;
         return res;
     }
     data += n;
@@ -507,7 +513,6 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
     if (size <= 3 || track < 0 || track >= num_tracks)
     {
         LTRACE(LT_INFO, 0, "Invalid stream " << track << " or size " << size);
-        delete[] origdata;
         return res;
     }
     if (tracks[track]->stream_index < 0)
@@ -524,8 +529,8 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
     {
     case 0x0: /* no lacing */
         laces = 1;
-        lace_size = reinterpret_cast<int32_t *>(new uint8_t[sizeof(int)]);
-        lace_size[0] = size;
+        m_laceSizes.assign(1, size);
+        lace_size = m_laceSizes.data();
         break;
 
     case 0x1: /* xiph lacing */
@@ -539,8 +544,8 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
         laces = (*data) + 1;
         data += 1;
         size -= 1;
-        lace_size = reinterpret_cast<int32_t *>(new uint8_t[laces * sizeof(int)]);
-        memset(lace_size, 0, static_cast<size_t>(laces) * sizeof(int));
+        m_laceSizes.assign(laces, 0);
+        lace_size = m_laceSizes.data();
 
         switch ((flags & 0x06) >> 1)
         {
@@ -606,6 +611,15 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
     default:;
     }
 
+    // the frames before the first key frame after a seek are dropped
+    if (res == 0 && !m_waitKeyFramePids.empty() && m_waitKeyFramePids.count(track + 1))
+    {
+        if (is_keyframe & PKT_FLAG_KEY)
+            m_waitKeyFramePids.erase(track + 1);
+        else
+            laces = 0;
+    }
+
     if (res == 0)
     {
         const int real_v = tracks[track]->flags & MATROSKA_TRACK_REAL_V;
@@ -649,8 +663,11 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
 
                 int offset = 0;
                 uint8_t *curPtr = data + slice_offset;
+                bool inBlock = true;  // the data of the slice is in the block buffer as is
                 m_tmpBuffer.clear();
-                if (tracks[track]->encodingAlgo == COMPRESSION_STRIP_HEADERS)
+                if (m_scanBlocks)
+                    slice_size = 0;  // only the timing of the frames is needed
+                else if (tracks[track]->encodingAlgo == COMPRESSION_STRIP_HEADERS)
                 {
                     offset = static_cast<int>(tracks[track]->encodingAlgoPriv.size());
                     if (offset)
@@ -659,6 +676,7 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
                         m_tmpBuffer.append(curPtr, offset);  // save data
                         memcpy(curPtr, tracks[track]->encodingAlgoPriv.data(),
                                offset);  // place extra header direct to data
+                        inBlock = false;
                     }
                 }
                 else if (tracks[track]->encodingAlgo == COMPRESSION_ZLIB)
@@ -666,18 +684,24 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
                     decompressData(curPtr, slice_size);
                     curPtr = m_tmpBuffer.data();
                     slice_size = static_cast<int>(m_tmpBuffer.size());
+                    inBlock = false;
                 }
 
-                if (tracks[track]->parsed_priv_data != nullptr)
+                if (tracks[track]->parsed_priv_data != nullptr && !m_scanBlocks)
                 {
                     tracks[track]->parsed_priv_data->extractData(pkt, curPtr, slice_size + offset);
                 }
                 else if (slice_size + offset > 0)
                 {
-                    pkt->data = new uint8_t[slice_size + offset];
                     pkt->size = slice_size + offset;
-                    // TODO : check compiler warning 'Reading invalid data from curPtr'
-                    memcpy(pkt->data, curPtr, slice_size + offset);
+                    if (inBlock)
+                        pkt->data = curPtr;  // the block stays in the cluster arena until the next cluster
+                    else
+                    {
+                        pkt->data = m_clusterArena.alloc(pkt->size);
+                        // TODO : check compiler warning 'Reading invalid data from curPtr'
+                        memcpy(pkt->data, curPtr, pkt->size);
+                    }
                 }
                 if (offset)
                     memcpy(curPtr, m_tmpBuffer.data(), offset);  // restore data
@@ -694,8 +718,6 @@ int MatroskaDemuxer::matroska_parse_block(uint8_t *data, int size, const int64_t
         }
     }
 
-    delete[] lace_size;
-    delete[] origdata;
     return res;
 }
 
@@ -732,7 +754,7 @@ int MatroskaDemuxer::matroska_parse_blockgroup(const int64_t cluster_time)
         case MATROSKA_ID_BLOCK:
         {
             pos = m_processedBytes;
-            res = ebml_read_binary(&id, &data, &size);
+            res = ebml_read_block(&id, &data, &size);
             break;
         }
 
@@ -802,7 +824,10 @@ int MatroskaDemuxer::ebml_read_uint(uint32_t *id, int64_t *num)
 
     /* big-endian ordening; build up number */
     *num = 0;
-    while (n++ < size) *num = *num << 8 | get_byte();
+    if (const uint8_t *data = takeBuffered(static_cast<unsigned>(size)))
+        for (n = 0; n < size; n++) *num = *num << 8 | data[n];
+    else
+        while (n++ < size) *num = *num << 8 | get_byte();
     return 0;
 }
 
@@ -906,6 +931,22 @@ int MatroskaDemuxer::ebml_read_binary(uint32_t *id, uint8_t **binary, int *size)
     return 0;
 }
 
+int MatroskaDemuxer::ebml_read_block(uint32_t *id, uint8_t **data, int *size)
+{
+    int64_t rlength;
+    int res;
+
+    if ((res = ebml_read_element_id(id, nullptr)) < 0 || (res = ebml_read_element_length(&rlength)) < 0)
+        return res;
+    *size = static_cast<int>(rlength);
+    *data = m_clusterArena.alloc(*size);
+    if (static_cast<int>(get_buffer(*data, *size)) != *size)
+    {
+        THROW(ERR_MATROSKA_PARSE, "Matroska parser: read error at pos " << m_processedBytes)
+    }
+    return 0;
+}
+
 int MatroskaDemuxer::matroska_parse_cluster()
 {
     int res = 0;
@@ -949,7 +990,7 @@ int MatroskaDemuxer::matroska_parse_cluster()
 
         case MATROSKA_ID_SIMPLEBLOCK:
             pos = m_processedBytes;
-            res = ebml_read_binary(&id, &data, &size);
+            res = ebml_read_block(&id, &data, &size);
             if (res == 0)
                 res = matroska_parse_block(data, size, pos, cluster_time, AV_NOPTS_VALUE, -1, 0);
             break;
@@ -1020,6 +1061,10 @@ void MatroskaDemuxer::openFile(const std::string &streamName)
     m_firstTimecode.clear();
     index_parsed = false;
     metadata_parsed = false;
+    m_seekHeadPos = -1;
+    m_scanBlocks = false;
+    m_waitKeyFramePids.clear();
+    indexes.clear();
 
     writing_app = nullptr;
     muxing_app = nullptr;
@@ -1031,13 +1076,7 @@ void MatroskaDemuxer::readClose()
 {
     delete[] writing_app;
     delete[] muxing_app;
-    while (!packets.empty())
-    {
-        const AVPacket *pkt = packets.front();
-        delete[] pkt->data;
-        delete pkt;
-        packets.pop();
-    }
+    matroska_clear_packets();
     for (int i = 0; i < num_tracks; i++) delete[] reinterpret_cast<char *>(tracks[i]);
 }
 
@@ -1075,7 +1114,10 @@ int MatroskaDemuxer::ebml_read_num(const int max_size, int64_t *number)
 
     /* read out length */
     total &= ~len_mask;
-    while (n++ < read) total = total << 8 | get_byte();
+    if (const uint8_t *data = takeBuffered(read - 1))
+        for (n = 0; n < read - 1; n++) total = total << 8 | data[n];
+    else
+        while (n++ < read) total = total << 8 | get_byte();
     *number = total;
     return read;
 }
@@ -1091,7 +1133,6 @@ int MatroskaDemuxer::readPacket(AVPacket &avPacket)
     uint32_t id;
     if (m_lastDeliveryPacket)
     {
-        delete[] m_lastDeliveryPacket->data;
         delete m_lastDeliveryPacket;
         m_lastDeliveryPacket = nullptr;
     }
@@ -1122,6 +1163,8 @@ int MatroskaDemuxer::readPacket(AVPacket &avPacket)
             case MATROSKA_ID_CLUSTER:
                 if ((res = ebml_read_master(&id)) < 0)
                     break;
+                // all the packets of the previous cluster are delivered, so its data is not used any more
+                m_clusterArena.reset();
                 if ((res = matroska_parse_cluster()) == 0)
                     res = 1;  // Parsed one cluster, let's get out.
                 break;
@@ -1266,6 +1309,9 @@ int MatroskaDemuxer::matroska_read_header()
         /* file index (if seekable, seek to Cues/Tags to parse it) */
         case MATROSKA_ID_SEEKHEAD:
         {
+            // parsed by seekToTime() if it needs the cues
+            if (m_seekHeadPos < 0)
+                m_seekHeadPos = m_processedBytes;
             ebml_read_skip();
             break;
         }
@@ -1345,6 +1391,8 @@ int MatroskaDemuxer::matroska_read_header()
             {
                 track->parsed_priv_data = new ParsedPGTrackData();
             }
+            if (track->parsed_priv_data)
+                track->parsed_priv_data->setPacketArena(&m_clusterArena);
         }
         res = 0;
     }
@@ -2365,6 +2413,239 @@ int MatroskaDemuxer::matroska_add_stream()
 
 // ------------- need to be implemented --------------
 
+void MatroskaDemuxer::matroska_clear_packets()
+{
+    while (!packets.empty())
+    {
+        delete packets.front();
+        packets.pop_front();
+    }
+    if (m_lastDeliveryPacket)
+    {
+        delete m_lastDeliveryPacket;
+        m_lastDeliveryPacket = nullptr;
+    }
+    m_clusterArena.reset();
+}
+
+void MatroskaDemuxer::matroska_reset_position(const int64_t pos, const uint32_t peekId, const int levels)
+{
+    matroska_clear_packets();
+    url_fseek(pos);
+    peek_id = peekId;
+    num_levels = levels;
+    level_up = 0;
+    done = false;
+}
+
+/* Read the position of the cues from the SeekHead element.
+ * Return: the position in the file or -1 if it is not found. */
+int64_t MatroskaDemuxer::matroska_find_cues()
+{
+    int64_t cuesPos = -1;
+    uint32_t id;
+    int res;
+    if ((res = ebml_read_master(&id)) < 0)
+        return -1;
+
+    while (res == 0)
+    {
+        if ((id = ebml_peek_id(&level_up)) == 0)
+            break;
+        if (level_up)
+        {
+            level_up--;
+            break;
+        }
+
+        if (id == MATROSKA_ID_SEEKENTRY)
+        {
+            if ((res = ebml_read_master(&id)) < 0)
+                break;
+            uint32_t seekId = 0;
+            int64_t seekPos = -1;
+            while (res == 0)
+            {
+                if ((id = ebml_peek_id(&level_up)) == 0)
+                {
+                    res = -BufferedReader::DATA_EOF;
+                    break;
+                }
+                if (level_up)
+                {
+                    level_up--;
+                    break;
+                }
+
+                switch (id)
+                {
+                case MATROSKA_ID_SEEKID:
+                {
+                    uint8_t *data;
+                    int size;
+                    if ((res = ebml_read_binary(&id, &data, &size)) < 0)
+                        break;
+                    for (int i = 0; i < size; i++) seekId = seekId << 8 | data[i];
+                    delete[] data;
+                    break;
+                }
+                case MATROSKA_ID_SEEKPOSITION:
+                    res = ebml_read_uint(&id, &seekPos);
+                    break;
+                default:
+                    res = ebml_read_skip();
+                }
+
+                if (level_up)
+                {
+                    level_up--;
+                    break;
+                }
+            }
+            if (seekId == MATROSKA_ID_CUES && seekPos >= 0)
+                cuesPos = static_cast<int64_t>(segment_start) + seekPos;
+        }
+        else
+            res = ebml_read_skip();
+
+        if (level_up)
+        {
+            level_up--;
+            break;
+        }
+    }
+
+    return cuesPos;
+}
+
+bool MatroskaDemuxer::seekToTime(std::map<int32_t, int64_t> &times)
+{
+    if (m_lastProcessedBytes != 0 || m_lastDeliveryPacket || !packets.empty() || !m_pidFilters.empty() ||
+        times.empty())
+        return false;
+    for (const auto &[pid, time] : times)
+        if (pid < 1 || pid > num_tracks)
+            return false;
+
+    // the parser state at the first cluster, restored if the seek fails
+    const int64_t startPos = m_processedBytes;
+    const uint32_t startPeekId = peek_id;
+    const int startLevels = num_levels;
+    bool rez = false;
+    m_scanBlocks = true;
+    try
+    {
+        rez = matroska_seek_cue_point(times, startPos, startPeekId, startLevels);
+    }
+    catch (const VodCoreException &e)
+    {
+        LTRACE(LT_WARN, 0, "Can't use the index of the file: " << e.m_errStr);
+    }
+    m_scanBlocks = false;
+    if (rez)
+        return true;
+    matroska_reset_position(startPos, startPeekId, startLevels);
+    m_firstTimecode.clear();
+    return false;
+}
+
+bool MatroskaDemuxer::matroska_seek_cue_point(std::map<int32_t, int64_t> &times, const int64_t startPos,
+                                              const uint32_t startPeekId, const int startLevels)
+{
+    if (indexes.empty() && m_seekHeadPos >= 0)
+    {
+        matroska_reset_position(m_seekHeadPos, MATROSKA_ID_SEEKHEAD, startLevels);
+        const int64_t cuesPos = matroska_find_cues();
+        if (cuesPos < 0)
+            return false;
+        matroska_reset_position(cuesPos, 0, startLevels);
+        uint32_t id;
+        if (ebml_read_master(&id) < 0 || id != MATROSKA_ID_CUES)
+            return false;
+        matroska_parse_index();
+    }
+
+    // cue points after the first cluster: time in the internal clock and position of the cluster
+    std::vector<std::pair<int64_t, int64_t>> cuePoints;
+    for (const MatroskaDemuxIndex &idx : indexes)
+        if (static_cast<int64_t>(idx.pos) > startPos)
+            cuePoints.emplace_back(llround(static_cast<double>(idx.time) * INTERNAL_PTS_FREQ / 1e9), idx.pos);
+    if (cuePoints.empty())
+        return false;
+    std::sort(cuePoints.begin(), cuePoints.end());
+
+    // the tracks timed by their stream readers, the other ones (subtitles) carry their own timestamps
+    std::set<int32_t> timedPids;
+    for (const auto &[pid, time] : times)
+    {
+        const int trackType = getTrackType(tracks[pid - 1]);
+        if (trackType != TRACKTYPE_SRT && trackType != TRACKTYPE_PGS)
+            timedPids.insert(pid);
+    }
+    if (timedPids.empty())
+        return false;
+
+    // the time of the first frame of each track, from the start of the file
+    matroska_reset_position(startPos, startPeekId, startLevels);
+    const auto firstTimeFound = [&]
+    {
+        for (const int32_t pid : timedPids)
+            if (m_firstTimecode.find(tracks[pid - 1]->num) == m_firstTimecode.end())
+                return false;
+        return true;
+    };
+    AVPacket packet;
+    while (!firstTimeFound())
+        if (readPacket(packet) != 0 || m_processedBytes > cuePoints.back().second)
+            return false;
+    std::map<int32_t, int64_t> firstTimes;
+    int64_t seekTime = LLONG_MAX;  // the earliest time a track must start at, in the internal clock
+    for (const int32_t pid : timedPids)
+    {
+        firstTimes[pid] = m_firstTimecode[tracks[pid - 1]->num] * INTERNAL_PTS_FREQ / 1000;
+        seekTime = FFMIN(seekTime, firstTimes[pid] + times[pid]);
+    }
+
+    auto cuePoint = std::upper_bound(cuePoints.begin(), cuePoints.end(), std::make_pair(seekTime, INT64_MAX));
+    for (int tries = 0; tries < MAX_CUE_POINT_TRIES && cuePoint != cuePoints.begin(); ++tries)
+    {
+        --cuePoint;
+        matroska_reset_position(cuePoint->second, 0, startLevels);
+
+        // the first key frame of each track must not be later than the time the track must start at
+        std::map<int32_t, int64_t> startTimes;
+        bool found = true;
+        while (found && startTimes.size() < timedPids.size())
+        {
+            if (readPacket(packet) != 0 || m_processedBytes - cuePoint->second > MAX_SEEK_SCAN_SIZE)
+                found = false;
+            else if (timedPids.count(packet.stream_index) && (packet.flags & PKT_FLAG_KEY) &&
+                     startTimes.find(packet.stream_index) == startTimes.end())
+            {
+                startTimes[packet.stream_index] = packet.pts;
+                found = packet.pts <= firstTimes[packet.stream_index] + times[packet.stream_index];
+            }
+        }
+        if (!found)
+            continue;
+
+        matroska_reset_position(cuePoint->second, 0, startLevels);
+        m_waitKeyFramePids = timedPids;
+        for (auto itr = times.begin(); itr != times.end();)
+        {
+            if (timedPids.count(itr->first))
+            {
+                itr->second = startTimes[itr->first] - firstTimes[itr->first];
+                ++itr;
+            }
+            else
+                itr = times.erase(itr);
+        }
+        return true;
+    }
+    return false;
+}
+
 int MatroskaDemuxer::simpleDemuxBlock(DemuxedData &demuxedData, const PIDSet &acceptedPIDs, int64_t &discardSize)
 {
     for (int acceptedPID : acceptedPIDs) demuxedData[acceptedPID];
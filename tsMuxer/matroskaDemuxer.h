@@ -1,13 +1,15 @@
 #ifndef MATROSKA_STREAM_READER_H_
 #define MATROSKA_STREAM_READER_H_
 
+#include <set>
+
 #include "ioContextDemuxer.h"
 #include "matroskaParser.h"
 
 class MatroskaDemuxer final : public IOContextDemuxer
 {
    public:
-    MatroskaDemuxer(const BufferedReaderManager &readManager);
+    MatroskaDemuxer(const BufferedReaderManager &readManager, const char *streamName);
     ~MatroskaDemuxer() override { readClose(); }
     void openFile(const std::string &streamName) override;
     int readPacket(AVPacket &avPacket);  // not implemented
@@ -23,6 +25,7 @@ class MatroskaDemuxer final : public IOContextDemuxer
     }
 
     [[nodiscard]] int64_t getFileDurationNano() const override { return fileDuration; }
+    bool seekToTime(std::map<int32_t, int64_t> &times) override;
 
    private:
     typedef Track MatroskaTrack;
@@ -43,7 +46,7 @@ class MatroskaDemuxer final : public IOContextDemuxer
 
     // ffmpeg matroska vars
     MatroskaLevel levels[EBML_MAX_DEPTH];
-    std::queue<AVPacket *> packets;
+    std::deque<AVPacket *> packets;
     std::vector<MatroskaDemuxIndex> indexes;
     // std::vector<MatroskaDemuxLevel> levels;
     int num_levels;
@@ -61,6 +64,9 @@ class MatroskaDemuxer final : public IOContextDemuxer
     std::map<int64_t, int64_t> m_firstTimecode;
     bool index_parsed;
     bool metadata_parsed;
+    int64_t m_seekHeadPos;                 // the position after the ID of the first SeekHead element or -1
+    bool m_scanBlocks;                     // the packets are read for their timing only, without the data
+    std::set<int32_t> m_waitKeyFramePids;  // the tracks which are read from their next key frame
     int num_streams;
 
     AVPacket *m_lastDeliveryPacket;
@@ -71,6 +77,7 @@ class MatroskaDemuxer final : public IOContextDemuxer
     int ebml_read_element_level_up();
     int matroska_parse_cluster();
     int ebml_read_binary(uint32_t *id, uint8_t **binary, int *size);
+    int ebml_read_block(uint32_t *id, uint8_t **data, int *size);
     int ebml_read_element_length(int64_t *length);
     int ebml_read_master(uint32_t *id);
     int ebml_read_skip();
@@ -89,6 +96,11 @@ class MatroskaDemuxer final : public IOContextDemuxer
     int ebml_read_header(char **doctype, int *version);
     int ebml_read_ascii(uint32_t *id, char **str);
     int matroska_parse_index();
+    int64_t matroska_find_cues();
+    bool matroska_seek_cue_point(std::map<int32_t, int64_t> &times, int64_t startPos, uint32_t startPeekId,
+                                 int startLevels);
+    void matroska_reset_position(int64_t pos, uint32_t peekId, int levels);
+    void matroska_clear_packets();
     int matroska_parse_info();
     int ebml_read_date(uint32_t *id, int64_t *date);
     int ebml_read_float(uint32_t *id, double *num);
@@ -108,6 +120,8 @@ class MatroskaDemuxer final : public IOContextDemuxer
 
     std::map<uint64_t, AVChapter> chapters;
     MemoryBlock m_tmpBuffer;
+    PacketArena m_clusterArena;    // the blocks and the packets of the current cluster
+    std::vector<int> m_laceSizes;  // the frame sizes of the current block
 };
 
 #endif
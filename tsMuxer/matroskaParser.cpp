@@ -144,8 +144,7 @@ void ParsedH264TrackData::extractData(AVPacket* pkt, uint8_t* buff, const int si
         LTRACE(LT_ERROR, 2, "Matroska parse error: invalid H264 NAL unit size. NAL unit truncated.");
     }
     newBufSize += elements * (4 - m_nalSize);
-    pkt->data = new uint8_t[newBufSize];
-    pkt->size = newBufSize;
+    allocPacketData(pkt, newBufSize);
 
     uint8_t* dst = pkt->data;
     if (m_firstExtract)
@@ -261,11 +260,8 @@ ParsedVC1TrackData::ParsedVC1TrackData(uint8_t* buff, const int size) : ParsedTr
 
 void ParsedVC1TrackData::extractData(AVPacket* pkt, uint8_t* buff, const int size)
 {
-    pkt->size = size + (m_firstPacket ? static_cast<int>(m_seqHeader.size()) : 0);
     const bool addFrameHdr = !(size >= 4 && buff[0] == 0 && buff[1] == 0 && buff[2] == 1);
-    if (addFrameHdr)
-        pkt->size += 4;
-    pkt->data = new uint8_t[pkt->size];
+    allocPacketData(pkt, size + (m_firstPacket ? static_cast<int>(m_seqHeader.size()) : 0) + (addFrameHdr ? 4 : 0));
     uint8_t* dst = pkt->data;
     if (m_firstPacket && !m_seqHeader.empty())
     {
@@ -297,8 +293,7 @@ ParsedAACTrackData::ParsedAACTrackData(uint8_t* buff, const int size) : ParsedTr
 
 void ParsedAACTrackData::extractData(AVPacket* pkt, uint8_t* buff, const int size)
 {
-    pkt->size = size + AAC_HEADER_LEN;
-    pkt->data = new uint8_t[pkt->size];
+    allocPacketData(pkt, size + AAC_HEADER_LEN);
     m_aacRaw.buildADTSHeader(pkt->data, size + AAC_HEADER_LEN);
     memcpy(pkt->data + AAC_HEADER_LEN, buff, size);
 }
@@ -320,8 +315,7 @@ ParsedLPCMTrackData::ParsedLPCMTrackData(MatroskaTrack* track)
 
 void ParsedLPCMTrackData::extractData(AVPacket* pkt, uint8_t* buff, const int size)
 {
-    pkt->size = size + static_cast<int>(m_waveBuffer.size());
-    pkt->data = new uint8_t[pkt->size];
+    allocPacketData(pkt, size + static_cast<int>(m_waveBuffer.size()));
     uint8_t* dst = pkt->data;
     if (!m_waveBuffer.isEmpty())
     {
@@ -351,8 +345,7 @@ void ParsedAC3TrackData::extractData(AVPacket* pkt, uint8_t* buff, const int siz
             m_shortHeaderMode = true;
     }
     m_firstPacket = false;
-    pkt->size = size + (m_shortHeaderMode ? 2 : 0);
-    pkt->data = new uint8_t[pkt->size];
+    allocPacketData(pkt, size + (m_shortHeaderMode ? 2 : 0));
     uint8_t* dst = pkt->data;
     if (m_shortHeaderMode)
     {
@@ -381,8 +374,7 @@ void ParsedSRTTrackData::extractData(AVPacket* pkt, uint8_t* buff, const int siz
     prefix += floatToTime(static_cast<double>(pkt->pts + pkt->duration) / INTERNAL_PTS_FREQ, ',');
     prefix += '\n';
     const std::string postfix = "\n\n";
-    pkt->size = static_cast<int>(size + prefix.length() + postfix.length());
-    pkt->data = new uint8_t[pkt->size];
+    allocPacketData(pkt, static_cast<int>(size + prefix.length() + postfix.length()));
     memcpy(pkt->data, prefix.c_str(), prefix.length());
     memcpy(pkt->data + prefix.length(), buff, size);
     memcpy(pkt->data + prefix.length() + size, postfix.c_str(), postfix.length());
@@ -412,8 +404,7 @@ void ParsedPGTrackData::extractData(AVPacket* pkt, uint8_t* buff, const int size
         return;  // ignore invalid packet
     }
 
-    pkt->size = size + PG_HEADER_SIZE * blocks;
-    pkt->data = new uint8_t[pkt->size];
+    allocPacketData(pkt, size + PG_HEADER_SIZE * blocks);
     curPtr = buff;
     uint8_t* dst = pkt->data;
     while (curPtr <= end - 3)
@@ -5,7 +5,10 @@
 
 #include <fs/textfile.h>
 #include <types/types.h>
+#include <atomic>
 #include <climits>
+#include <functional>
+#include <thread>
 
 #include "aacStreamReader.h"
 #include "ac3StreamReader.h"
@@ -23,7 +26,9 @@
 #include "mpegAudioStreamReader.h"
 #include "mpegStreamReader.h"
 #include "pgsStreamReader.h"
+#include "probeCache.h"
 #include "programStreamDemuxer.h"
+#include "simplePacketizerReader.h"
 #include "srtStreamReader.h"
 #include "subTrackFilter.h"
 #include "tsDemuxer.h"
@@ -36,6 +41,42 @@ using namespace std;
 
 static constexpr int MAX_DEMUX_BUFFER_SIZE = 1024 * 1024 * 192;
 static constexpr int MIN_READED_BLOCK = 16384;
+static constexpr size_t MAX_PREPARE_THREADS = 8;
+
+// Run task(0) .. task(count - 1) on several threads. The tasks only prepare the inputs: an exception thrown by one of
+// them is ignored, and the failed work is done again and reported by the code which needs its result.
+static void runParallel(const size_t count, const std::function<void(size_t)>& task)
+{
+    std::atomic<size_t> next = 0;
+    const auto worker = [&]
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            try
+            {
+                task(i);
+            }
+            catch (...)
+            {
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(count, MAX_PREPARE_THREADS); ++i) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+}
+
+// the tracks of the file are read by a container demuxer, if a track number is given
+static bool isContainerFile(const string& fileName)
+{
+    const string name = unquoteStr(trimStr(strToLowerCase(fileName)));
+    for (const char* ext : {".h264", ".264", ".mvc", ".ts", ".m2ts", ".mts", ".ssif", ".vob", ".evo", ".mpg", ".mkv",
+                            ".mka", ".mks", ".mov", ".mp4", ".m4v", ".m4a"})
+        if (strEndWith(name, ext))
+            return true;
+    return false;
+}
 
 METADemuxer::METADemuxer(const BufferedReaderManager& readManager)
     : m_containerReader(*this, readManager), m_readManager(readManager)
@@ -168,6 +209,8 @@ void METADemuxer::openFile(const string& streamName)
     readClose();
 
     TextFile file(m_streamName.c_str(), File::ofRead);
+    vector<MetaTrack> tracks;
+    string invalidLine;
     string str;
     file.readLine(str);
     while (str.length() > 0)
@@ -185,7 +228,11 @@ void METADemuxer::openFile(const string& streamName)
         }
         vector<string> params = splitQuotedStr(str.c_str(), ',');
         if (params.size() < 2)
-            THROW(ERR_INVALID_CODEC_FORMAT, "Invalid codec format: " << str)
+        {
+            // reported after the tracks above it are added, as they were added line by line
+            invalidLine = str;
+            break;
+        }
         map<string, string> addParams;
         for (unsigned i = 2; i < params.size(); i++)
         {
@@ -198,10 +245,16 @@ void METADemuxer::openFile(const string& streamName)
         codec = strToUpperCase(codec);
         if (!m_HevcFound)
             m_HevcFound = (codec.find("HEVC") == 12);
-        addStream(codec, codecStreamName, addParams);
+        tracks.push_back({codec, codecStreamName, addParams});
         file.readLine(str);
     }
 
+    // the inputs are opened concurrently, the tracks are added in the order of the meta file
+    prepareInputs(tracks);
+    for (const MetaTrack& track : tracks) addStream(track.codec, track.codecStreamName, track.addParams);
+    if (!invalidLine.empty())
+        THROW(ERR_INVALID_CODEC_FORMAT, "Invalid codec format: " << invalidLine)
+
     auto primarySEI = H264StreamReader::SeiMethod::SEI_NotDefined;
     for (const auto& si : m_codecInfo)
     {
@@ -262,6 +315,42 @@ std::string METADemuxer::mplsTrackToSSIFName(const std::string& mplsFileName, co
     return path + mplsNum + string(".") + ssifExt;
 }
 
+void METADemuxer::seekToTime(const int64_t time)
+{
+    // the tracks of each container and the time they must start at
+    map<string, map<int32_t, int64_t>> containerTimes;
+    for (const StreamInfo& si : m_codecInfo)
+        if (si.m_dataReader == &m_containerReader)
+            containerTimes[si.m_streamName][si.m_pid] = time - si.m_timeShift;
+
+    const auto minTime = [](const map<int32_t, int64_t>& times)
+    {
+        int64_t rez = LLONG_MAX;
+        for (const auto& [pid, trackTime] : times) rez = FFMIN(rez, trackTime);
+        return rez;
+    };
+    for (auto& [streamName, times] : containerTimes)
+    {
+        if (minTime(times) <= 0 || !m_containerReader.seekToTime(streamName, times))
+            continue;
+
+        // the stream readers count the time from the first data they get
+        for (StreamInfo& si : m_codecInfo)
+        {
+            const auto itr = times.find(si.m_pid);
+            if (si.m_dataReader != &m_containerReader || si.m_streamName != streamName || itr == times.end())
+                continue;
+            si.m_streamReader->setTimeOffset(si.m_streamReader->getTimeOffset() + itr->second);
+            si.m_lastDTS += itr->second;
+            if (const auto reader = dynamic_cast<SimplePacketizerReader*>(si.m_streamReader))
+                reader->skipMplsTime(itr->second);
+        }
+        LTRACE(LT_INFO, 2,
+               "File " << streamName << " is read from "
+                       << floatToTime(static_cast<double>(minTime(times)) / INTERNAL_PTS_FREQ));
+    }
+}
+
 int METADemuxer::addPGSubStream(const string& codec, const string& _codecStreamName,
                                 const map<string, string>& addParams, const MPLSStreamInfo* subStream)
 {
@@ -309,38 +398,12 @@ int METADemuxer::addStream(const string& codec, const string& codecStreamName, c
     if (fileExt == "mpls" || fileExt == "mpl")
     {
         mplsInfoList = getMplsInfo(codecStreamName);
+        fileList = getPlaylistFiles(codecStreamName, isSubStream, mplsInfoList);
         vector<string> mplsNames = splitQuotedStr(codecStreamName.c_str(), '+');
         for (size_t k = 0; k < mplsInfoList.size(); ++k)
         {
-            MPLSParser& mplsInfo = mplsInfoList[k];
             unquotedStreamName = unquoteStr(mplsNames[k]);
-            for (size_t i = 0; i < mplsInfo.m_playItems.size(); ++i)
-            {
-                string playItemName;
-                if (isSubStream)
-                {
-                    if (mplsInfo.m_mvcFiles.empty())
-                    {
-                        THROW(ERR_INVALID_CODEC_FORMAT,
-                              "Current playlist file doesn't has MVC track info. Please, remove MVC track from the "
-                              "track list")
-                    }
-                    if (mplsInfo.m_mvcFiles.size() <= i)
-                        THROW(ERR_INVALID_CODEC_FORMAT,
-                              "Bad playlist file: number of CLPI files for AVC and VMC parts do not match")
-                    playItemName = mplsInfo.m_mvcFiles[i];
-                }
-                else
-                {
-                    playItemName = mplsInfo.m_playItems[i].fileName;
-                }
-                string fileName = mplsTrackToFullName(unquotedStreamName, playItemName);
-                if (mplsInfo.isDependStreamExist && !fileExists(fileName))
-                    fileName = mplsTrackToSSIFName(unquotedStreamName, mplsInfo.m_playItems[i].fileName);
-                fileList.push_back(fileName);
-            }
-
-            MPLSStreamInfo streamInfo = mplsInfo.getStreamByPID(pid);
+            MPLSStreamInfo streamInfo = mplsInfoList[k].getStreamByPID(pid);
             if (streamInfo.stream_coding_type == StreamType::SUB_PGS && streamInfo.isSSPG)
             {
                 // add refs to addition tracks for stereo subtitles
@@ -383,11 +446,22 @@ int METADemuxer::addStream(const string& codec, const string& codecStreamName, c
 
     int64_t fileSize = 0;
 
-    if (m_containerReader.m_demuxers.find(fileList[0]) == m_containerReader.m_demuxers.end())
+    // a demuxer opened by prepareInputs() is not used by any track yet
+    const auto demuxerData = m_containerReader.m_demuxers.find(fileList[0]);
+    if (demuxerData == m_containerReader.m_demuxers.end() || demuxerData->second.m_pids.empty())
     {
         File tmpFile;
         for (const string& fileName : fileList)
         {
+            // the size of a pipe is unknown, and opening it for a moment could make the writer fail
+            if (isPipeInput(fileName.c_str()))
+                continue;
+            const auto inputSize = m_inputSizes.find(fileName);
+            if (inputSize != m_inputSizes.end())
+            {
+                fileSize += inputSize->second;
+                continue;
+            }
             if (!tmpFile.open(fileName.c_str(), File::ofRead))
                 THROW(ERR_INVALID_CODEC_FORMAT, "Can't open file: " << fileName.c_str())
             int64_t tmpSize = 0;
@@ -480,14 +554,21 @@ int METADemuxer::addStream(const string& codec, const string& codecStreamName, c
         THROW(ERR_INVALID_CODEC_FORMAT, "This version do not support multicast or other network steams for muxing")
     }
 
-    m_codecInfo.emplace_back(dataReader, codecReader, fileList[0], codecStreamName, pid, isSubStream);
-    if (listIterator)
+    if (dataReader != &m_containerReader && isPipeInput(fileList[0].c_str()))
     {
-        auto fileReader = dynamic_cast<BufferedFileReader*>(dataReader);
-        if (fileReader)
-            fileReader->setFileIterator(listIterator, m_codecInfo.rbegin()->m_readerID);
+        // each track has its own reader, which would take a part of the data of the other one
+        for (const StreamInfo& si : m_codecInfo)
+            if (si.m_streamName == fileList[0])
+            {
+                delete codecReader;
+                THROW(ERR_INVALID_CODEC_FORMAT, "Only one track can be read from the pipe " << fileList[0])
+            }
     }
 
+    m_codecInfo.emplace_back(dataReader, codecReader, fileList[0], codecStreamName, pid, isSubStream);
+    if (listIterator)
+        dataReader->setFileIterator(listIterator, m_codecInfo.rbegin()->m_readerID);
+
     StreamInfo& streamInfo = *m_codecInfo.rbegin();
     streamInfo.m_codec = codec;
     streamInfo.m_addParams = addParams;
@@ -556,7 +637,26 @@ void METADemuxer::readClose()
 }
 
 DetectStreamRez METADemuxer::DetectStreamReader(const BufferedReaderManager& readManager, const string& fileName,
-                                                bool calcDuration)
+                                                const bool calcDuration)
+{
+    const string unquoted = unquoteStr(fileName);
+    const string fileExt = strToLowerCase(extractFileExt(unquoted));
+    // the languages of a Blu-ray stream are taken from its clip info file
+    string clpiFileName;
+    if (fileExt == "m2ts" || fileExt == "mts" || fileExt == "ssif")
+        clpiFileName = findBluRayFile(extractFileDir(unquoted), "CLIPINF", extractFileName(unquoted) + ".clpi");
+
+    DetectStreamRez rez;
+    if (ProbeCache::load(unquoted, clpiFileName, calcDuration, rez))
+        return rez;
+    rez = detectStreams(readManager, fileName, clpiFileName, calcDuration);
+    if (!rez.streams.empty())
+        ProbeCache::store(unquoted, clpiFileName, calcDuration, rez);
+    return rez;
+}
+
+DetectStreamRez METADemuxer::detectStreams(const BufferedReaderManager& readManager, const string& fileName,
+                                           const string& clpiFileName, bool calcDuration)
 {
     AVChapters chapters;
     int64_t fileDuration = 0;
@@ -569,35 +669,34 @@ DetectStreamRez METADemuxer::DetectStreamReader(const BufferedReaderManager& rea
     bool clpiParsed = false;
     if (fileExt == "m2ts" || fileExt == "mts" || fileExt == "ssif")
     {
-        demuxer = new TSDemuxer(readManager, "");
+        demuxer = new TSDemuxer(readManager, unquoted.c_str());
         containerType = AbstractStreamReader::ContainerType::ctM2TS;
-        string clpiFileName = findBluRayFile(extractFileDir(unquoted), "CLIPINF", extractFileName(unquoted) + ".clpi");
         if (!clpiFileName.empty())
             clpiParsed = clpi.parse(clpiFileName.c_str());
     }
     else if (fileExt == "ts")
     {
-        demuxer = new TSDemuxer(readManager, "");
+        demuxer = new TSDemuxer(readManager, unquoted.c_str());
         containerType = AbstractStreamReader::ContainerType::ctTS;
     }
     else if (fileExt == "vob" || fileExt == "mpg")
     {
-        demuxer = new ProgramStreamDemuxer(readManager);
+        demuxer = new ProgramStreamDemuxer(readManager, unquoted.c_str());
         containerType = AbstractStreamReader::ContainerType::ctVOB;
     }
     else if (fileExt == "evo")
     {
-        demuxer = new ProgramStreamDemuxer(readManager);
+        demuxer = new ProgramStreamDemuxer(readManager, unquoted.c_str());
         containerType = AbstractStreamReader::ContainerType::ctEVOB;
     }
     else if (fileExt == "mkv" || fileExt == "mka" || fileExt == "mks")
     {
-        demuxer = new MatroskaDemuxer(readManager);
+        demuxer = new MatroskaDemuxer(readManager, unquoted.c_str());
         containerType = AbstractStreamReader::ContainerType::ctMKV;
     }
     else if (fileExt == "mp4" || fileExt == "m4v" || fileExt == "m4a" || fileExt == "mov")
     {
-        demuxer = new MovDemuxer(readManager);
+        demuxer = new MovDemuxer(readManager, unquoted.c_str());
         containerType = AbstractStreamReader::ContainerType::ctMOV;
     }
 
@@ -618,14 +717,44 @@ DetectStreamRez METADemuxer::DetectStreamReader(const BufferedReaderManager& rea
             vect.reserve(fileBlockSize);
         }
 
-        for (unsigned i = 0; i < DETECT_STREAM_BUFFER_SIZE / fileBlockSize; i++)
-            demuxer->simpleDemuxBlock(demuxedData, acceptedPidSet, discardedSize);
+        // The tracks are checked on a growing part of the file. A track is detected once its result stays the same
+        // after the amount of data is doubled, and the demuxing stops when all the tracks are detected
+        map<int32_t, CheckStreamRez> detected;  // the last result of each track
+        set<int32_t> done;
+        // a pipe can be read again only up to DETECT_STREAM_BUFFER_SIZE
+        const int64_t maxSize = isPipeInput(unquoted.c_str()) ? DETECT_STREAM_BUFFER_SIZE : DETECT_STREAM_MAX_SIZE;
+        int64_t demuxedSize = 0;
+        bool eof = false;
+        for (int64_t checkSize = DETECT_STREAM_MIN_SIZE; !eof && demuxedSize < maxSize; checkSize *= 2)
+        {
+            while (!eof && demuxedSize < checkSize)
+            {
+                eof = demuxer->simpleDemuxBlock(demuxedData, acceptedPidSet, discardedSize) == BufferedReader::DATA_EOF;
+                demuxedSize += fileBlockSize;
+                for (const int32_t pid : done) demuxedData[pid].clear();
+            }
+            for (auto& itr : demuxedData)
+            {
+                if (done.count(itr.first))
+                    continue;
+                StreamData& vect = itr.second;
+                CheckStreamRez trackRez = detectTrackReader(vect.data(), static_cast<int>(vect.size()), containerType,
+                                                            acceptedPidMap[itr.first].m_trackType, itr.first);
+                const auto prevRez = detected.find(itr.first);
+                // more data is read past DETECT_STREAM_BUFFER_SIZE only for the tracks which have almost none
+                if ((trackRez.codecInfo.codecID && prevRez != detected.end() &&
+                     sameTrackInfo(prevRez->second, trackRez)) ||
+                    (demuxedSize >= DETECT_STREAM_BUFFER_SIZE && vect.size() >= DETECT_STREAM_MIN_SIZE))
+                    done.insert(itr.first);
+                detected[itr.first] = trackRez;
+            }
+            if (done.size() == demuxedData.size())
+                break;
+        }
 
-        for (auto& itr : demuxedData)
+        for (auto& itr : detected)
         {
-            StreamData& vect = itr.second;
-            CheckStreamRez trackRez = detectTrackReader(vect.data(), static_cast<int>(vect.size()), containerType,
-                                                        acceptedPidMap[itr.first].m_trackType, itr.first);
+            CheckStreamRez trackRez = itr.second;
             if (!trackRez.codecInfo.programName.empty())
             {
                 if (trackRez.codecInfo.programName[0] != 'S')
@@ -664,7 +793,8 @@ DetectStreamRez METADemuxer::DetectStreamReader(const BufferedReaderManager& rea
                 addTrack(streams, trackRez);
         }
         chapters = demuxer->getChapters();
-        if (calcDuration)
+        // the end of a pipe can't be read before the muxing
+        if (calcDuration && !isPipeInput(unquoted.c_str()))
             fileDuration = demuxer->getFileDurationNano();
         delete demuxer;
     }
@@ -674,22 +804,45 @@ DetectStreamRez METADemuxer::DetectStreamReader(const BufferedReaderManager& rea
         containerType = AbstractStreamReader::ContainerType::ctNone;
         if (!file.open(fileName.c_str(), File::ofRead))
             return {};
-        auto tmpBuffer = new uint8_t[DETECT_STREAM_BUFFER_SIZE];
-        int len = file.read(tmpBuffer, DETECT_STREAM_BUFFER_SIZE);
         if (fileExt == "sup")
             containerType = AbstractStreamReader::ContainerType::ctSUP;
         else if (fileExt == "pcm" || fileExt == "lpcm" || fileExt == "wav" || fileExt == "w64")
             containerType = AbstractStreamReader::ContainerType::ctLPCM;
         else if (fileExt == "srt")
             containerType = AbstractStreamReader::ContainerType::ctSRT;
-        CheckStreamRez trackRez = detectTrackReader(tmpBuffer, len, containerType, 0, 0);
+
+        // the same growing check as for the container tracks, up to DETECT_STREAM_BUFFER_SIZE
+        std::vector<uint8_t> tmpBuffer;
+        CheckStreamRez trackRez;
+        bool eof = false;
+        for (size_t checkSize = DETECT_STREAM_MIN_SIZE; !eof; checkSize *= 2)
+        {
+            checkSize = FFMIN(checkSize, DETECT_STREAM_BUFFER_SIZE);
+            size_t len = tmpBuffer.size();
+            tmpBuffer.resize(checkSize);
+            // a pipe returns the data in small parts
+            while (len < checkSize)
+            {
+                const int rez = file.read(tmpBuffer.data() + len, static_cast<uint32_t>(checkSize - len));
+                if (rez <= 0)
+                {
+                    eof = true;
+                    break;
+                }
+                len += rez;
+            }
+            tmpBuffer.resize(len);
+            const CheckStreamRez prevRez = trackRez;
+            trackRez = detectTrackReader(tmpBuffer.data(), static_cast<int>(len), containerType, 0, 0);
+            if ((trackRez.codecInfo.codecID && sameTrackInfo(prevRez, trackRez)) ||
+                checkSize == DETECT_STREAM_BUFFER_SIZE)
+                break;
+        }
 
         if (strStartWith(trackRez.codecInfo.programName, "V_"))
             addTrack(Vstreams, trackRez);
         else
             addTrack(streams, trackRez);
-
-        delete[] tmpBuffer;
     }
     Vstreams.insert(Vstreams.end(), streams.begin(), streams.end());
 
@@ -700,6 +853,12 @@ DetectStreamRez METADemuxer::DetectStreamReader(const BufferedReaderManager& rea
     return rez;
 }
 
+bool METADemuxer::sameTrackInfo(const CheckStreamRez& rez1, const CheckStreamRez& rez2)
+{
+    return rez1.codecInfo.codecID == rez2.codecInfo.codecID && rez1.streamDescr == rez2.streamDescr &&
+           rez1.multiSubStream == rez2.multiSubStream;
+}
+
 void METADemuxer::addTrack(vector<CheckStreamRez>& rez, CheckStreamRez trackRez)
 {
     if (trackRez.codecInfo.codecID == h264DepCodecInfo.codecID && trackRez.multiSubStream)
@@ -1154,6 +1313,139 @@ std::vector<MPLSParser> METADemuxer::getMplsInfo(const string& mplsFileName)
     return result;
 }
 
+std::vector<std::string> METADemuxer::getPlaylistFiles(const string& mplsFileName, const bool isSubStream,
+                                                       const std::vector<MPLSParser>& mplsInfoList)
+{
+    std::vector<std::string> fileList;
+    std::vector<std::string> mplsNames = splitQuotedStr(mplsFileName.c_str(), '+');
+    for (size_t k = 0; k < mplsInfoList.size(); ++k)
+    {
+        const MPLSParser& mplsInfo = mplsInfoList[k];
+        const string unquotedStreamName = unquoteStr(mplsNames[k]);
+        for (size_t i = 0; i < mplsInfo.m_playItems.size(); ++i)
+        {
+            string playItemName;
+            if (isSubStream)
+            {
+                if (mplsInfo.m_mvcFiles.empty())
+                {
+                    THROW(ERR_INVALID_CODEC_FORMAT,
+                          "Current playlist file doesn't has MVC track info. Please, remove MVC track from the "
+                          "track list")
+                }
+                if (mplsInfo.m_mvcFiles.size() <= i)
+                    THROW(ERR_INVALID_CODEC_FORMAT,
+                          "Bad playlist file: number of CLPI files for AVC and VMC parts do not match")
+                playItemName = mplsInfo.m_mvcFiles[i];
+            }
+            else
+            {
+                playItemName = mplsInfo.m_playItems[i].fileName;
+            }
+            string fileName = mplsTrackToFullName(unquotedStreamName, playItemName);
+            if (mplsInfo.isDependStreamExist && !fileExists(fileName))
+                fileName = mplsTrackToSSIFName(unquotedStreamName, mplsInfo.m_playItems[i].fileName);
+            fileList.push_back(fileName);
+        }
+    }
+    return fileList;
+}
+
+void METADemuxer::prepareInputs(const std::vector<MetaTrack>& tracks)
+{
+    // the playlists give the names of the clips, so they are parsed first
+    set<string> playlistSet;
+    for (const MetaTrack& track : tracks)
+    {
+        const string fileExt = strToLowerCase(extractFileExt(track.codecStreamName));
+        if (fileExt != "mpls" && fileExt != "mpl")
+            continue;
+        for (const string& mplsName : splitQuotedStr(track.codecStreamName.c_str(), '+'))
+            if (m_mplsStreamMap.find(mplsName) == m_mplsStreamMap.end())
+                playlistSet.insert(mplsName);
+    }
+    const vector<string> playlists(playlistSet.begin(), playlistSet.end());
+    vector<MPLSParser> parsers(playlists.size());
+    vector<uint8_t> parsed(playlists.size());
+    runParallel(playlists.size(),
+                [&](const size_t i) { parsed[i] = parsers[i].parse(unquoteStr(playlists[i]).c_str()); });
+    for (size_t i = 0; i < playlists.size(); ++i)
+        if (parsed[i])
+            m_mplsStreamMap[playlists[i]] = parsers[i];
+
+    set<string> fileSet;
+    vector<pair<ContainerToReaderWrapper::DemuxerData*, int>> demuxers;
+    for (const MetaTrack& track : tracks)
+    {
+        const bool isSubStream = (track.codec == h264DepCodecInfo.programName) ||
+                                 track.addParams.find("subClip") != track.addParams.end();
+        const string fileExt = strToLowerCase(extractFileExt(track.codecStreamName));
+        vector<string> fileList;
+        try
+        {
+            if (fileExt == "mpls" || fileExt == "mpl")
+                fileList = getPlaylistFiles(track.codecStreamName, isSubStream, getMplsInfo(track.codecStreamName));
+            else
+                fileList = extractFileList(track.codecStreamName);
+        }
+        catch (const VodCoreException&)
+        {
+            continue;  // reported by addStream()
+        }
+        for (const string& fileName : fileList)
+            if (!isPipeInput(fileName.c_str()) && m_inputSizes.find(fileName) == m_inputSizes.end())
+                fileSet.insert(fileName);
+
+        const auto trackParam = track.addParams.find("track");
+        const int pid = trackParam != track.addParams.end() ? strToInt32(trackParam->second.c_str()) : 0;
+        if (fileList.empty() || pid == 0 || !isContainerFile(fileList[0]) ||
+            m_containerReader.m_demuxers.find(fileList[0]) != m_containerReader.m_demuxers.end())
+            continue;
+        // the same demuxer state as the first addStream() of the container would create
+        ContainerToReaderWrapper::DemuxerData& demuxerData = m_containerReader.m_demuxers[fileList[0]];
+        demuxerData.m_streamName = fileList[0];
+        if (fileList.size() > 1)
+        {
+            auto listIterator = new FileListIterator();
+            m_iterators.push_back(listIterator);
+            for (const string& fileName : fileList) listIterator->addFile(fileName);
+            demuxerData.m_iterator = listIterator;
+        }
+        demuxers.emplace_back(&demuxerData, pid);
+    }
+
+    const vector<string> files(fileSet.begin(), fileSet.end());
+    vector<int64_t> sizes(files.size(), -1);
+    runParallel(files.size() + demuxers.size(),
+                [&](const size_t i)
+                {
+                    if (i < files.size())
+                    {
+                        File file;
+                        if (file.open(files[i].c_str(), File::ofRead))
+                            file.size(&sizes[i]);
+                        return;
+                    }
+                    ContainerToReaderWrapper::DemuxerData& demuxerData = *demuxers[i - files.size()].first;
+                    AbstractDemuxer* demuxer =
+                        m_containerReader.createDemuxer(demuxerData.m_streamName, demuxers[i - files.size()].second);
+                    try
+                    {
+                        demuxer->setFileIterator(demuxerData.m_iterator);
+                        demuxer->openFile(demuxerData.m_streamName);
+                    }
+                    catch (...)
+                    {
+                        delete demuxer;
+                        throw;
+                    }
+                    demuxerData.m_demuxer = demuxer;
+                });
+    for (size_t i = 0; i < files.size(); ++i)
+        if (sizes[i] >= 0)
+            m_inputSizes[files[i]] = sizes[i];
+}
+
 string METADemuxer::findBluRayFile(const string& streamDir, const string& requestDir, const string& requestFile)
 {
     string dirName = streamDir.substr(0, streamDir.size() - 1);
@@ -1245,7 +1537,11 @@ int StreamInfo::read()
         }
         m_lastAVRez = 0;
 
-        m_data = m_dataReader->readBlock(m_readerID, m_blockSize, readRez);
+        // a reader which copies the data anyway takes it from the container demuxer without gathering it first
+        const bool sliceRead = m_streamReader->gathersSlices() &&
+                               m_dataReader->readSlices(m_readerID, m_slices, m_blockSize, readRez);
+        if (!sliceRead)
+            m_data = m_dataReader->readBlock(m_readerID, m_blockSize, readRez);
         if (readRez == BufferedFileReader::DATA_NOT_READY || readRez == BufferedFileReader::DATA_DELAYED)
         {
             m_lastAVRez = readRez;
@@ -1253,7 +1549,10 @@ int StreamInfo::read()
         }
         if (readRez == BufferedFileReader::DATA_EOF)
             m_isEOF = true;
-        m_streamReader->setBuffer(m_data, m_blockSize, m_isEOF);
+        if (sliceRead)
+            m_streamReader->setBufferSlices(m_slices, m_blockSize, m_isEOF);
+        else
+            m_streamReader->setBuffer(m_data, m_blockSize, m_isEOF);
         m_readCnt += m_blockSize;
         m_notificated = false;
     }
@@ -1262,10 +1561,39 @@ int StreamInfo::read()
 
 // ------------------------------ ContainerToReaderWrapper --------------------------------
 
+void ContainerToReaderWrapper::dropReadData(DemuxerData& demuxerData, const int pid) const
+{
+    const uint32_t lastReadCnt = demuxerData.lastReadCnt[pid];
+    if (lastReadCnt > 0)
+    {
+        demuxerData.demuxedData[pid].consume(m_readBuffOffset, lastReadCnt);
+        demuxerData.lastReadCnt[pid] = 0;
+    }
+    demuxerData.lastReadSlices[pid] = false;
+}
+
 uint8_t* ContainerToReaderWrapper::readBlock(const int readerID, uint32_t& readCnt, int& rez, bool* firstBlockVar)
+{
+    StreamData* streamData = readStreamData(readerID, readCnt, rez, false);
+    return streamData ? streamData->data() : nullptr;
+}
+
+bool ContainerToReaderWrapper::readSlices(const int readerID, std::vector<DataSlice>& slices, uint32_t& readCnt,
+                                          int& rez)
+{
+    slices.clear();
+    const StreamData* streamData = readStreamData(readerID, readCnt, rez, true);
+    if (streamData && readCnt > 0)
+        streamData->getSlices(m_readBuffOffset, readCnt, slices);
+    return true;
+}
+
+StreamData* ContainerToReaderWrapper::readStreamData(const int readerID, uint32_t& readCnt, int& rez,
+                                                     const bool sliceRead)
 {
     rez = 0;
-    uint8_t* data = nullptr;
+    readCnt = 0;
+    StreamData* data = nullptr;
     const auto itr = m_readerInfo.find(readerID);
     if (itr == m_readerInfo.end())
         return nullptr;
@@ -1286,20 +1614,7 @@ uint8_t* ContainerToReaderWrapper::readBlock(const int readerID, uint32_t& readC
     }
     StreamData& streamData = demuxerData.demuxedData[pid];
 
-    const uint32_t lastReadCnt = demuxerData.lastReadCnt[pid];
-    if (lastReadCnt > 0)
-    {
-        demuxerData.lastReadCnt[pid] = 0;
-        const size_t currentSize = streamData.size() - m_readBuffOffset;
-        assert(currentSize >= lastReadCnt);
-        if (currentSize > lastReadCnt)
-        {
-            uint8_t* dataStart = streamData.data() + m_readBuffOffset;
-            memmove(dataStart, dataStart + lastReadCnt, static_cast<size_t>(currentSize) - lastReadCnt);
-        }
-        streamData.resize(static_cast<int>(m_readBuffOffset + currentSize - lastReadCnt));
-        demuxerData.lastReadCnt[pid] = 0;
-    }
+    dropReadData(demuxerData, pid);
 
     readCnt = static_cast<uint32_t>((FFMIN(streamData.size(), nFileBlockSize) - m_readBuffOffset));
     const DemuxerReadPolicy policy = demuxerData.m_pids[pid];
@@ -1307,12 +1622,18 @@ uint8_t* ContainerToReaderWrapper::readBlock(const int readerID, uint32_t& readC
                          demuxerData.lastReadCnt[pid] == DATA_EOF2)) ||
         readCnt >= MIN_READED_BLOCK)
     {
-        data = streamData.data();
+        data = &streamData;
         demuxerData.lastReadCnt[pid] = readCnt;
+        demuxerData.lastReadSlices[pid] = sliceRead;
         demuxerData.lastReadRez[pid] = 0;
     }
     else if (demuxerData.lastReadRez[pid] != DATA_DELAYED || demuxerData.m_allFragmented)
     {
+        // the data returned as slices is already copied by the readers, and it may refer to the demuxer's buffer
+        // which is reused by the next demuxing
+        for (const auto& lastRead : demuxerData.lastReadSlices)
+            if (lastRead.second)
+                dropReadData(demuxerData, static_cast<int>(lastRead.first));
         int demuxRez;
         do
         {
@@ -1338,7 +1659,8 @@ uint8_t* ContainerToReaderWrapper::readBlock(const int readerID, uint32_t& readC
                  !m_terminated);
 
         demuxerData.lastReadCnt[pid] = readCnt;
-        data = streamData.data();
+        demuxerData.lastReadSlices[pid] = sliceRead;
+        data = &streamData;
         if (readCnt > 0)
         {
             rez = demuxerData.m_demuxer->getLastReadRez();
@@ -1378,6 +1700,14 @@ void ContainerToReaderWrapper::resetDelayedMark() const
     }
 }
 
+ContainerToReaderWrapper::~ContainerToReaderWrapper()
+{
+    // the demuxers opened in advance for the tracks which were not added
+    for (const auto& demuxerData : m_demuxers)
+        if (demuxerData.second.m_pids.empty())
+            delete demuxerData.second.m_demuxer;
+}
+
 int ContainerToReaderWrapper::createReader(const int readBuffOffset)
 {
     m_readBuffOffset = readBuffOffset;
@@ -1399,39 +1729,29 @@ void ContainerToReaderWrapper::deleteReader(const int readerID)
     m_readerInfo.erase(itr);
 }
 
+AbstractDemuxer* ContainerToReaderWrapper::createDemuxer(const string& streamName, const int pid) const
+{
+    string ext = strToUpperCase(extractFileExt(streamName));
+    if ((ext == "264" || ext == "H264" || ext == "MVC") && pid)
+        return new CombinedH264Demuxer(m_readManager, streamName.c_str());
+    if (ext == "TS" || ext == "M2TS" || ext == "MTS" || ext == "M2T" || ext == "SSIF")
+        return new TSDemuxer(m_readManager, streamName.c_str());
+    if (ext == "EVO" || ext == "VOB" || ext == "MPG" || ext == "MPEG")
+        return new ProgramStreamDemuxer(m_readManager, streamName.c_str());
+    if (ext == "MKV" || ext == "MKA" || ext == "MKS")
+        return new MatroskaDemuxer(m_readManager, streamName.c_str());
+    if (ext == "MOV" || ext == "MP4" || ext == "M4V" || ext == "M4A")
+        return new MovDemuxer(m_readManager, streamName.c_str());
+    THROW(ERR_UNSUPPORTER_CONTAINER_FORMAT, "Unsupported container format: " << streamName)
+}
+
 bool ContainerToReaderWrapper::openStream(int readerID, const char* streamName, int pid, const CodecInfo* codecInfo)
 {
     AbstractDemuxer* demuxer = m_demuxers[streamName].m_demuxer;
     if (demuxer == nullptr)
     {
-        string ext = strToUpperCase(extractFileExt(streamName));
-        if ((ext == "264" || ext == "H264" || ext == "MVC") && pid)
-        {
-            demuxer = m_demuxers[streamName].m_demuxer = new CombinedH264Demuxer(m_readManager, "");
-            m_demuxers[streamName].m_streamName = streamName;
-        }
-        else if (ext == "TS" || ext == "M2TS" || ext == "MTS" || ext == "M2T" || ext == "SSIF")
-        {
-            demuxer = m_demuxers[streamName].m_demuxer = new TSDemuxer(m_readManager, "");
-            m_demuxers[streamName].m_streamName = streamName;
-        }
-        else if (ext == "EVO" || ext == "VOB" || ext == "MPG" || ext == "MPEG")
-        {
-            demuxer = m_demuxers[streamName].m_demuxer = new ProgramStreamDemuxer(m_readManager);
-            m_demuxers[streamName].m_streamName = streamName;
-        }
-        else if (ext == "MKV" || ext == "MKA" || ext == "MKS")
-        {
-            demuxer = m_demuxers[streamName].m_demuxer = new MatroskaDemuxer(m_readManager);
-            m_demuxers[streamName].m_streamName = streamName;
-        }
-        else if (ext == "MOV" || ext == "MP4" || ext == "M4V" || ext == "M4A")
-        {
-            demuxer = m_demuxers[streamName].m_demuxer = new MovDemuxer(m_readManager);
-            m_demuxers[streamName].m_streamName = streamName;
-        }
-        else
-            THROW(ERR_UNSUPPORTER_CONTAINER_FORMAT, "Unsupported container format: " << streamName)
+        demuxer = m_demuxers[streamName].m_demuxer = createDemuxer(streamName, pid);
+        m_demuxers[streamName].m_streamName = streamName;
         demuxer->setFileIterator(m_demuxers[streamName].m_iterator);
 
         demuxer->openFile(streamName);
@@ -1472,8 +1792,25 @@ bool ContainerToReaderWrapper::openStream(int readerID, const char* streamName,
     return true;
 }
 
+bool ContainerToReaderWrapper::seekToTime(const string& streamName, std::map<int32_t, int64_t>& times)
+{
+    const auto itr = m_demuxers.find(streamName);
+    if (itr == m_demuxers.end() || !itr->second.m_demuxer || !itr->second.m_firstRead)
+        return false;
+    // only the TS demuxer seeks in the list of files
+    if (itr->second.m_iterator && !dynamic_cast<TSDemuxer*>(itr->second.m_demuxer))
+        return false;
+    return itr->second.m_demuxer->seekToTime(times);
+}
+
 void ContainerToReaderWrapper::setFileIterator(const char* streamName, FileNameIterator* itr)
 {
-    if (m_demuxers[streamName].m_iterator == nullptr)
-        m_demuxers[streamName].m_iterator = itr;
+    DemuxerData& demuxerData = m_demuxers[streamName];
+    if (demuxerData.m_iterator == nullptr)
+    {
+        demuxerData.m_iterator = itr;
+        // the demuxer was opened in advance and is not used by any track yet
+        if (demuxerData.m_demuxer && demuxerData.m_pids.empty())
+            demuxerData.m_demuxer->setFileIterator(itr);
+    }
 }
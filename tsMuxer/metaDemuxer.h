@@ -53,6 +53,7 @@ struct StreamInfo
     uint32_t m_blockSize;
     int64_t m_lastDTS;
     uint8_t* m_data;
+    std::vector<DataSlice> m_slices;
     std::string m_streamName;
     std::string m_fullStreamName;
     int lastReadRez;
@@ -88,6 +89,7 @@ class ContainerToReaderWrapper final : public AbstractReader
         FileNameIterator* m_iterator;
         std::map<uint32_t, uint32_t> lastReadCnt;
         std::map<uint32_t, uint32_t> lastReadRez;
+        std::map<uint32_t, bool> lastReadSlices;  // the last data was returned by readSlices()
         DemuxerData()
         {
             m_demuxer = nullptr;
@@ -120,7 +122,9 @@ class ContainerToReaderWrapper final : public AbstractReader
         m_discardedSize = 0;
         m_terminated = false;
     }
+    ~ContainerToReaderWrapper() override;
     uint8_t* readBlock(int readerID, uint32_t& readCnt, int& rez, bool* firstBlockVar = nullptr) override;
+    bool readSlices(int readerID, std::vector<DataSlice>& slices, uint32_t& readCnt, int& rez) override;
     bool seek(int readerID, int64_t offset) override { return false; }
     bool incSeek(int readerID, int64_t offset) override { return false; }
     void notify(int readerID, uint32_t dataReaded) override {}
@@ -128,6 +132,10 @@ class ContainerToReaderWrapper final : public AbstractReader
     void deleteReader(int readerID) override;
     bool openStream(int readerID, const char* streamName, int pid = 0, const CodecInfo* codecInfo = nullptr) override;
     void setFileIterator(const char* streamName, FileNameIterator* itr);
+    // skip the start of a container which is not read yet, see AbstractDemuxer::seekToTime()
+    bool seekToTime(const std::string& streamName, std::map<int32_t, int64_t>& times);
+    // create the demuxer of a container, the file is not opened yet
+    AbstractDemuxer* createDemuxer(const std::string& streamName, int pid) const;
     void resetDelayedMark() const;
     [[nodiscard]] int64_t getDiscardedSize() const { return m_discardedSize; }
 
@@ -136,6 +144,9 @@ class ContainerToReaderWrapper final : public AbstractReader
     std::map<std::string, DemuxerData> m_demuxers;
 
    private:
+    StreamData* readStreamData(int readerID, uint32_t& readCnt, int& rez, bool sliceRead);
+    void dropReadData(DemuxerData& demuxerData, int pid) const;
+
     int64_t m_discardedSize;
     int32_t m_readerCnt;
     size_t m_readBuffOffset;
@@ -167,6 +178,8 @@ class METADemuxer final : public AbstractDemuxer
     int addStream(const std::string& codec, const std::string& codecStreamName,
                   const std::map<std::string, std::string>& addParams);
     void openFile(const std::string& streamName) override;
+    // skip the data of the containers which is not needed to start at the given time
+    void seekToTime(int64_t time);
     [[nodiscard]] const std::vector<StreamInfo>& getStreamInfo() const { return m_codecInfo; }
     static DetectStreamRez DetectStreamReader(const BufferedReaderManager& readManager, const std::string& fileName,
                                               bool calcDuration);
@@ -175,9 +188,20 @@ class METADemuxer final : public AbstractDemuxer
     [[nodiscard]] int64_t totalSize() const { return m_totalSize; }
     static std::string mplsTrackToFullName(const std::string& mplsFileName, const std::string& mplsNum);
     static std::string mplsTrackToSSIFName(const std::string& mplsFileName, const std::string& mplsNum);
+    // the file in a sibling directory of the Blu-ray stream directory (or of its BACKUP copy) or an empty string
+    static std::string findBluRayFile(const std::string& streamDir, const std::string& requestDir,
+                                      const std::string& requestFile);
     bool m_HevcFound;
 
    private:
+    // a track line of the meta file
+    struct MetaTrack
+    {
+        std::string codec;
+        std::string codecStreamName;
+        std::map<std::string, std::string> addParams;
+    };
+
     std::vector<FileListIterator*> m_iterators;
     int m_lastReadRez;
     ContainerToReaderWrapper m_containerReader;
@@ -193,6 +217,7 @@ class METADemuxer final : public AbstractDemuxer
     // MPLSPlayItemsMap m_mplsStreamMap;
     MPLSCache m_mplsStreamMap;
     std::set<std::string> m_processedTracks;
+    std::map<std::string, int64_t> m_inputSizes;  // sizes of the input files read by prepareInputs()
 
     friend class ContainerToReaderWrapper;
 
@@ -202,16 +227,21 @@ class METADemuxer final : public AbstractDemuxer
                                              const std::vector<MPLSPlayItem>& mplsInfo);
     inline void updateReport(bool checkTime);
     void lineBack();
+    static DetectStreamRez detectStreams(const BufferedReaderManager& readManager, const std::string& fileName,
+                                         const std::string& clpiFileName, bool calcDuration);
     static CheckStreamRez detectTrackReader(uint8_t* tmpBuffer, int len,
                                             AbstractStreamReader::ContainerType containerType, int containerDataType,
                                             int containerStreamIndex);
-    static std::string findBluRayFile(const std::string& streamDir, const std::string& requestDir,
-                                      const std::string& requestFile);
     std::vector<MPLSParser> getMplsInfo(const std::string& mplsFileName);
+    static std::vector<std::string> getPlaylistFiles(const std::string& mplsFileName, bool isSubStream,
+                                                     const std::vector<MPLSParser>& mplsInfoList);
+    void prepareInputs(const std::vector<MetaTrack>& tracks);
 
     int addPGSubStream(const std::string& codec, const std::string& _codecStreamName,
                        const std::map<std::string, std::string>& addParams, const MPLSStreamInfo* subStream);
     static void addTrack(std::vector<CheckStreamRez>& rez, CheckStreamRez trackRez);
+    // the results of the track detection are the same
+    static bool sameTrackInfo(const CheckStreamRez& rez1, const CheckStreamRez& rez2);
     static std::vector<MPLSPlayItem> mergePlayItems(const std::vector<MPLSParser>& mplsInfoList);
 };
 
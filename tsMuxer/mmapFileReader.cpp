@@ -0,0 +1,272 @@
+#include "mmapFileReader.h"
+
+#include <fs/systemlog.h>
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "vod_common.h"
+
+using namespace std;
+
+#ifndef _WIN32
+namespace
+{
+size_t pageSize()
+{
+    static const auto size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+size_t roundUpToPage(const size_t value) { return (value + pageSize() - 1) / pageSize() * pageSize(); }
+
+int toFd(const File& file) { return static_cast<int>(reinterpret_cast<std::intptr_t>(file.nativeHandle())); }
+}  // namespace
+#endif
+
+MmapFileReader::MmapFileReader(const uint32_t blockSize, const uint32_t allocSize, const uint32_t prereadThreshold)
+    : m_lastReaderID(0)
+{
+    m_blockSize = blockSize;
+    m_allocSize = allocSize ? allocSize : blockSize;
+    m_prereadThreshold = prereadThreshold ? prereadThreshold : m_blockSize / 2;
+}
+
+MmapFileReader::~MmapFileReader()
+{
+    for (const auto& stream : m_streams)
+    {
+        unmapWindow(stream.second);
+        delete stream.second;
+    }
+}
+
+bool MmapFileReader::isSupported()
+{
+#ifdef _WIN32
+    return false;
+#else
+    return true;
+#endif
+}
+
+MmapFileReader::MappedStream* MmapFileReader::getStream(const int readerID)
+{
+    std::lock_guard lock(m_streamsMtx);
+    const auto itr = m_streams.find(readerID);
+    return itr != m_streams.end() ? itr->second : nullptr;
+}
+
+int MmapFileReader::createReader(const int readBuffOffset)
+{
+    auto stream = new MappedStream();
+    stream->m_readOffset = readBuffOffset;
+    stream->m_nextBlockSize = m_blockSize;
+    stream->m_eofBlock.resize(std::max<size_t>(m_allocSize, readBuffOffset));
+
+    std::lock_guard lock(m_streamsMtx);
+    const int readerID = ++m_lastReaderID;
+    m_streams[readerID] = stream;
+    return readerID;
+}
+
+void MmapFileReader::deleteReader(const int readerID)
+{
+    std::lock_guard lock(m_streamsMtx);
+    const auto itr = m_streams.find(readerID);
+    if (itr == m_streams.end())
+        return;
+    unmapWindow(itr->second);
+    delete itr->second;
+    m_streams.erase(itr);
+}
+
+bool MmapFileReader::openStream(const int readerID, const char* streamName, int, const CodecInfo*)
+{
+    MappedStream* stream = getStream(readerID);
+    if (stream == nullptr)
+    {
+        LTRACE(LT_ERROR, 0, "Unknown readerID " << readerID);
+        return false;
+    }
+    if (!openFile(stream, streamName))
+        return false;
+    stream->m_firstBlock = false;
+    return true;
+}
+
+bool MmapFileReader::openFile(MappedStream* stream, const std::string& streamName)
+{
+    unmapWindow(stream);
+    stream->m_file.close();
+    stream->m_streamName = streamName;
+    stream->m_pos = 0;
+    stream->m_nextBlockSize = m_blockSize;
+    if (!stream->m_file.open(streamName.c_str(), File::ofRead))
+        return false;
+#ifndef _WIN32
+    struct stat st;
+    if (fstat(toFd(stream->m_file), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        LTRACE(LT_ERROR, 2, "File " << streamName << " is not a regular file and can't be memory mapped");
+        stream->m_file.close();
+        return false;
+    }
+    stream->m_fileSize = st.st_size;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool MmapFileReader::openNextFile(MappedStream* stream)
+{
+    if (stream->itr == nullptr)
+        return false;
+    const std::string nextFileName = stream->itr->getNextName();
+    if (nextFileName.empty() || nextFileName == stream->m_streamName || !openFile(stream, nextFileName))
+        return false;
+    stream->m_firstBlock = true;
+    return true;
+}
+
+bool MmapFileReader::mapWindow(MappedStream* stream, const int64_t pos, const uint32_t size)
+{
+    unmapWindow(stream);
+#ifndef _WIN32
+    const int64_t start = pos / static_cast<int64_t>(pageSize()) * static_cast<int64_t>(pageSize());
+    const int64_t end = pos + size;
+    const auto fileMapSize = static_cast<size_t>(end - start);
+    // anonymous pages around the file data: the headroom in front of the block, and a tail which keeps reads
+    // slightly past the end of the block inside the mapping, as with the allocSize of BufferedReader
+    const size_t headroom = roundUpToPage(std::max<size_t>(stream->m_readOffset, 1));
+    const size_t tail = roundUpToPage(m_allocSize > m_blockSize ? m_allocSize - m_blockSize : 1);
+    const size_t windowSize = headroom + roundUpToPage(fileMapSize) + tail;
+
+    void* window =
+        mmap(nullptr, windowSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (window == MAP_FAILED)
+        return false;
+    uint8_t* fileData = static_cast<uint8_t*>(window) + headroom;
+    if (mmap(fileData, fileMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, toFd(stream->m_file), start) ==
+        MAP_FAILED)
+    {
+        munmap(window, windowSize);
+        return false;
+    }
+    madvise(fileData, fileMapSize, MADV_SEQUENTIAL);
+
+    stream->m_window = static_cast<uint8_t*>(window);
+    stream->m_windowSize = windowSize;
+    stream->m_headroom = headroom;
+    stream->m_windowStart = start;
+    stream->m_windowEnd = end;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MmapFileReader::unmapWindow(MappedStream* stream)
+{
+#ifndef _WIN32
+    if (stream->m_window)
+        munmap(stream->m_window, stream->m_windowSize);
+#endif
+    stream->m_window = nullptr;
+    stream->m_windowSize = 0;
+    stream->m_windowStart = stream->m_windowEnd = 0;
+}
+
+uint8_t* MmapFileReader::readBlock(const int readerID, uint32_t& readCnt, int& rez, bool* firstBlockVar)
+{
+    readCnt = 0;
+    rez = DATA_EOF;
+    MappedStream* stream = getStream(readerID);
+    if (stream == nullptr)
+        return nullptr;
+    while (stream->m_pos >= stream->m_fileSize)
+    {
+        if (!openNextFile(stream))
+        {
+            if (firstBlockVar)
+                *firstBlockVar = stream->m_firstBlock;
+            return stream->m_eofBlock.data();
+        }
+    }
+
+    const auto size =
+        static_cast<uint32_t>(std::min<int64_t>(stream->m_nextBlockSize, stream->m_fileSize - stream->m_pos));
+    // every block gets a window of its own. The demuxer writes in front of the block, with a window shared by several
+    // blocks it would overwrite the private copy of the previous one, which a backward seek would read again
+    if (!mapWindow(stream, stream->m_pos, size))
+    {
+        LTRACE(LT_ERROR, 2, "Can't map file " << stream->m_streamName << " into memory");
+        return stream->m_eofBlock.data();
+    }
+    uint8_t* data = stream->m_window + stream->m_headroom + (stream->m_pos - stream->m_windowStart);
+    stream->m_pos += size;
+    stream->m_nextBlockSize = m_blockSize;
+
+    readCnt = size;
+    rez = 0;
+    if (firstBlockVar)
+        *firstBlockVar = stream->m_firstBlock;
+    stream->m_firstBlock = false;
+    return data - stream->m_readOffset;
+}
+
+void MmapFileReader::prefetch(MappedStream* stream)
+{
+#if !defined(_WIN32) && !defined(__APPLE__)
+    // the next block is mapped by the next readBlock(), so it is read ahead through the page cache
+    const int64_t end = std::min<int64_t>(stream->m_fileSize, stream->m_pos + m_blockSize);
+    if (end > stream->m_pos)
+        posix_fadvise(toFd(stream->m_file), stream->m_pos, end - stream->m_pos, POSIX_FADV_WILLNEED);
+#endif
+}
+
+void MmapFileReader::notify(const int readerID, const uint32_t dataReaded)
+{
+    if (dataReaded < m_prereadThreshold)
+        return;
+    MappedStream* stream = getStream(readerID);
+    if (stream && stream->m_file.isOpen())
+        prefetch(stream);
+}
+
+bool MmapFileReader::seek(const int readerID, const int64_t offset) { return incSeek(readerID, offset); }
+
+bool MmapFileReader::incSeek(const int readerID, const int64_t offset)
+{
+    MappedStream* stream = getStream(readerID);
+    if (stream == nullptr)
+        return false;
+    stream->m_pos = std::max<int64_t>(0, stream->m_pos + offset);
+    return true;
+}
+
+bool MmapFileReader::gotoByte(const int readerID, const int64_t seekDist)
+{
+    MappedStream* stream = getStream(readerID);
+    if (stream == nullptr)
+        return false;
+    stream->m_pos = seekDist;
+    stream->m_nextBlockSize = m_blockSize - static_cast<uint32_t>(seekDist % static_cast<uint64_t>(m_blockSize));
+    return true;
+}
+
+bool MmapFileReader::setFileIterator(FileNameIterator* itr, const int readerID)
+{
+    MappedStream* stream = getStream(readerID);
+    if (stream == nullptr)
+        return false;
+    stream->itr = itr;
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef MMAP_FILE_READER_H_
+#define MMAP_FILE_READER_H_
+
+#include <fs/file.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "abstractDemuxer.h"
+#include "abstractReader.h"
+
+// Reads local files through memory mapped windows. readBlock() returns pointers into the mapping instead of copying
+// the data into a buffer. As with BufferedReader, the data starts readBuffOffset bytes after the returned pointer:
+// each block is mapped in a window of its own with writable headroom in front of it, so the demuxers can still copy
+// the tail of the previous block there. The mapping is private and dropped at the next block, so these writes change
+// neither the file nor the data of other blocks.
+class MmapFileReader final : public AbstractReader
+{
+   public:
+    MmapFileReader(uint32_t blockSize, uint32_t allocSize = 0, uint32_t prereadThreshold = 0);
+    ~MmapFileReader() override;
+
+    static bool isSupported();
+
+    int createReader(int readBuffOffset = 0) override;
+    void deleteReader(int readerID) override;
+    bool openStream(int readerID, const char* streamName, int pid = 0, const CodecInfo* codecInfo = nullptr) override;
+    uint8_t* readBlock(int readerID, uint32_t& readCnt, int& rez, bool* firstBlockVar = nullptr) override;
+    void notify(int readerID, uint32_t dataReaded) override;
+    bool seek(int readerID, int64_t offset) override;
+    bool incSeek(int readerID, int64_t offset) override;
+    bool gotoByte(int readerID, int64_t seekDist) override;
+    bool setFileIterator(FileNameIterator* itr, int readerID) override;
+
+   private:
+    struct MappedStream
+    {
+        MappedStream()
+            : itr(nullptr),
+              m_fileSize(0),
+              m_pos(0),
+              m_nextBlockSize(0),
+              m_readOffset(0),
+              m_firstBlock(false),
+              m_window(nullptr),
+              m_windowSize(0),
+              m_headroom(0),
+              m_windowStart(0),
+              m_windowEnd(0)
+        {
+        }
+
+        FileNameIterator* itr;
+        File m_file;
+        std::string m_streamName;
+        int64_t m_fileSize;
+        int64_t m_pos;             // file offset of the next block
+        uint32_t m_nextBlockSize;  // the block after gotoByte() is shorter, so the next ones are aligned
+        uint32_t m_readOffset;
+        bool m_firstBlock;
+
+        // currently mapped part of the file: [m_windowStart, m_windowEnd) is mapped at m_window + m_headroom
+        uint8_t* m_window;
+        size_t m_windowSize;
+        size_t m_headroom;
+        int64_t m_windowStart;
+        int64_t m_windowEnd;
+
+        std::vector<uint8_t> m_eofBlock;  // returned when there is no more data
+    };
+
+    MappedStream* getStream(int readerID);
+    bool openFile(MappedStream* stream, const std::string& streamName);
+    bool openNextFile(MappedStream* stream);
+    bool mapWindow(MappedStream* stream, int64_t pos, uint32_t size);
+    static void unmapWindow(MappedStream* stream);
+    void prefetch(MappedStream* stream);
+
+    std::mutex m_streamsMtx;
+    std::map<int, MappedStream*> m_streams;
+    int m_lastReaderID;
+};
+
+#endif
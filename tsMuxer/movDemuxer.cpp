@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <climits>
+#include <cmath>
 
 #include <fs/systemlog.h>
 
@@ -112,7 +113,8 @@ struct MOVStreamContext : Track
           bits_per_coded_sample(0),
           channels(0),
           packet_size(0),
-          sample_rate(0)
+          sample_rate(0),
+          m_skipSize(0)
     {
     }
 
@@ -150,8 +152,39 @@ struct MOVStreamContext : Track
     // vector<MOVDref> drefs;
     vector<MOVStts> stts_data;
     vector<MOVStts> ctts_data;
+    int64_t m_skipSize;  // the size of the samples before the one seekToTime() starts the track from
 };
 
+// decoding time of the sample in the track time scale
+static int64_t sampleTime(const MOVStreamContext* sc, const uint32_t sample)
+{
+    int64_t time = 0;
+    uint32_t left = sample;
+    for (const MOVStts& stts : sc->stts_data)
+    {
+        const uint32_t count = std::min(stts.count, left);
+        time += count * stts.duration;
+        left -= count;
+        if (left == 0)
+            break;
+    }
+    return time;
+}
+
+// the sample which is decoded at the time (in the track time scale)
+static uint32_t sampleAtTime(const MOVStreamContext* sc, int64_t time)
+{
+    uint32_t sample = 0;
+    for (const MOVStts& stts : sc->stts_data)
+    {
+        if (stts.duration > 0 && time < stts.count * stts.duration)
+            return sample + static_cast<uint32_t>(time / stts.duration);
+        time -= stts.count * stts.duration;
+        sample += stts.count;
+    }
+    return sample;
+}
+
 class MovParsedAudioTrackData final : public ParsedTrackPrivData
 {
    public:
@@ -605,8 +638,8 @@ class MovParsedSRTTrackData final : public ParsedTrackPrivData
     int64_t m_timeOffset;
 };
 
-MovDemuxer::MovDemuxer(const BufferedReaderManager& readManager)
-    : IOContextDemuxer(readManager), m_mdat_size(0), m_fileSize(0), m_timescale(0), fragment()
+MovDemuxer::MovDemuxer(const BufferedReaderManager& readManager, const char* streamName)
+    : IOContextDemuxer(readManager, streamName), m_mdat_size(0), m_fileSize(0), m_timescale(0), fragment()
 {
     found_moov = 0;
     found_moof = false;
@@ -720,13 +753,41 @@ int MovDemuxer::simpleDemuxBlock(DemuxedData& demuxedData, const PIDSet& accepte
         if (!chunks.empty())
         {
             discardSize += chunks[m_curChunk].first;
-            skip_bytes(chunks[m_curChunk].first);
+            if (m_curChunk > 0)
+                url_fseek(m_mdat_pos + chunks[m_curChunk].first);  // set by seekToTime()
+            else
+                skip_bytes(chunks[m_curChunk].first);
         }
     }
+    const auto isDemuxed = [&](const int64_t trackId)
+    {
+        return m_pidFilters.find(static_cast<int>(trackId) + 1) != m_pidFilters.end() ||
+               acceptedPIDs.find(static_cast<int>(trackId) + 1) != acceptedPIDs.end();
+    };
     const int64_t startPos = m_processedBytes;
     while (m_processedBytes - startPos < m_fileBlockSize && m_curChunk < chunks.size())
     {
         const int64_t offset = chunks[m_curChunk].first;
+        if (!found_moof && !isDemuxed(chunks[m_curChunk].second))
+        {
+            // the chunks of the other tracks are passed by a seek if they reach beyond the read-ahead of the reader,
+            // a shorter run is cheaper to read through
+            size_t runEnd = m_curChunk + 1;
+            while (runEnd < chunks.size() && !isDemuxed(chunks[runEnd].second)) runEnd++;
+            const int64_t runEndPos = runEnd < chunks.size() ? chunks[runEnd].first : m_mdat_size;
+            if (runEndPos - offset > m_readManager.getReadAheadSize())
+            {
+                discardSize += runEndPos - offset;
+                url_fseek(m_mdat_pos + runEndPos);
+                m_curChunk = runEnd;
+                if (m_curChunk == chunks.size())
+                {
+                    m_firstDemux = true;
+                    m_mdat_pos = 0;
+                }
+                continue;
+            }
+        }
         int64_t next;
         if (m_curChunk < chunks.size() - 1)
             next = chunks[m_curChunk + 1].first;
@@ -736,10 +797,19 @@ int MovDemuxer::simpleDemuxBlock(DemuxedData& demuxedData, const PIDSet& accepte
             m_firstDemux = true;
             m_mdat_pos = 0;
         }
-        const auto chunkSize = static_cast<int>(found_moof ? m_mdat_data[m_curChunk].second : next - offset);
+        auto chunkSize = static_cast<int>(found_moof ? m_mdat_data[m_curChunk].second : next - offset);
         const int trackId = static_cast<int>(chunks[m_curChunk].second);
         auto filterItr = m_pidFilters.find(trackId + 1);
-        if (filterItr == m_pidFilters.end() && acceptedPIDs.find(trackId + 1) == acceptedPIDs.end())
+        const auto st = reinterpret_cast<MOVStreamContext*>(tracks[trackId]);
+        if (st->m_skipSize > 0 && isDemuxed(trackId))
+        {
+            const int skipped = static_cast<int>(std::min<int64_t>(st->m_skipSize, chunkSize));
+            discardSize += skipped;
+            skip_bytes(skipped);
+            st->m_skipSize -= skipped;
+            chunkSize -= skipped;
+        }
+        if (!isDemuxed(trackId))
         {
             discardSize += chunkSize;
             skip_bytes(chunkSize);
@@ -747,7 +817,6 @@ int MovDemuxer::simpleDemuxBlock(DemuxedData& demuxedData, const PIDSet& accepte
         else if (chunkSize)
         {
             MemoryBlock& vect = demuxedData[trackId + 1];
-            const auto st = reinterpret_cast<MOVStreamContext*>(tracks[trackId]);
             const size_t oldSize = vect.size();
             if (st->parsed_priv_data)
             {
@@ -831,6 +900,86 @@ int MovDemuxer::simpleDemuxBlock(DemuxedData& demuxedData, const PIDSet& accepte
     return m_lastReadRez;
 }
 
+bool MovDemuxer::seekToTime(std::map<int32_t, int64_t>& times)
+{
+    if (found_moof || !m_firstDemux || m_curChunk != 0 || m_fileIterator || !m_pidFilters.empty() || times.empty())
+        return false;
+
+    // the positions in the chunk list of the chunks of each track, and the first sample of each of these chunks
+    vector<vector<size_t>> chunkPos(num_tracks);
+    vector<vector<uint32_t>> chunkSamples(num_tracks);
+    for (size_t i = 0; i < chunks.size(); ++i) chunkPos[chunks[i].second].push_back(i);
+    for (int i = 0; i < num_tracks; ++i)
+    {
+        const auto st = reinterpret_cast<MOVStreamContext*>(tracks[i]);
+        // the chunks of a track must be stored in their order
+        if (chunkPos[i].size() != st->chunk_offsets.size() ||
+            !std::is_sorted(st->chunk_offsets.begin(), st->chunk_offsets.end()))
+            return false;
+        uint32_t sample = 0;
+        size_t stscIdx = 0;
+        for (size_t chunk = 0; chunk < st->chunk_offsets.size(); ++chunk)
+        {
+            chunkSamples[i].push_back(sample);
+            while (stscIdx + 1 < st->stsc_data.size() && st->stsc_data[stscIdx + 1].first <= chunk + 1) ++stscIdx;
+            sample += st->stsc_data.empty() ? 1 : st->stsc_data[stscIdx].count;
+        }
+    }
+
+    // the first chunk of the tracks to read and the sample each of the tracks starts from
+    size_t pos = chunks.size();
+    std::map<int32_t, uint32_t> startSamples;
+    for (const auto& [pid, time] : times)
+    {
+        if (pid < 1 || pid > num_tracks)
+            return false;
+        const auto st = reinterpret_cast<MOVStreamContext*>(tracks[pid - 1]);
+        if (st->type == IOContextTrackType::SUBTITLE || st->time_scale == 0 || chunkPos[pid - 1].empty())
+            return false;
+        const auto trackTime = static_cast<int64_t>(static_cast<double>(time) * st->time_scale / INTERNAL_PTS_FREQ);
+        uint32_t sample = sampleAtTime(st, trackTime);
+        if (!st->keyframes.empty())
+        {
+            // the sample numbers of the key frames start at 1
+            auto keyframe = std::upper_bound(st->keyframes.begin(), st->keyframes.end(), sample + 1);
+            if (keyframe == st->keyframes.begin())
+                return false;
+            sample = *--keyframe - 1;
+            if (st->sample_size == 0 && sample >= st->m_index.size())
+                return false;
+            startSamples[pid] = sample;
+        }
+        const auto& samples = chunkSamples[pid - 1];
+        const auto chunk = std::upper_bound(samples.begin(), samples.end(), sample) - samples.begin() - 1;
+        pos = std::min(pos, chunkPos[pid - 1][chunk]);
+    }
+    if (pos == 0 && std::all_of(startSamples.begin(), startSamples.end(), [](const auto& s) { return s.second == 0; }))
+        return false;
+
+    // a track with key frames starts from the selected one, the samples of its chunks before it are skipped. The
+    // other tracks start from their first chunk after the seek point
+    m_curChunk = pos;
+    for (int i = 0; i < num_tracks; ++i)
+    {
+        const auto st = reinterpret_cast<MOVStreamContext*>(tracks[i]);
+        const auto& trackPos = chunkPos[i];
+        const size_t chunk = std::lower_bound(trackPos.begin(), trackPos.end(), pos) - trackPos.begin();
+        uint32_t sample =
+            chunk < trackPos.size() ? chunkSamples[i][chunk] : static_cast<uint32_t>(st->m_index.size());
+        const auto startSample = startSamples.find(i + 1);
+        if (startSample != startSamples.end())
+        {
+            for (; sample < startSample->second; ++sample)
+                st->m_skipSize += st->sample_size ? st->sample_size : st->m_index[sample];
+        }
+        st->m_indexCur = sample;
+        const auto itr = times.find(i + 1);
+        if (itr != times.end())
+            itr->second = llround(static_cast<double>(sampleTime(st, sample)) * INTERNAL_PTS_FREQ / st->time_scale);
+    }
+    return true;
+}
+
 void MovDemuxer::getTrackList(std::map<int32_t, TrackInfo>& trackList)
 {
     for (int i = 0; i < num_tracks; i++)
@@ -12,7 +12,7 @@
 class MovDemuxer final : public IOContextDemuxer
 {
    public:
-    MovDemuxer(const BufferedReaderManager& readManager);
+    MovDemuxer(const BufferedReaderManager& readManager, const char* streamName);
     ~MovDemuxer() override { readClose(); }
     void openFile(const std::string& streamName) override;
     void readClose() override;
@@ -27,6 +27,7 @@ class MovDemuxer final : public IOContextDemuxer
     void setFileIterator(FileNameIterator* itr) override;
     [[nodiscard]] bool isPidFilterSupported() const override { return true; }
     [[nodiscard]] int64_t getFileDurationNano() const override;
+    bool seekToTime(std::map<int32_t, int64_t>& times) override;
 
    private:
     struct MOVAtom
@@ -22,12 +22,36 @@ void MPEGStreamReader::setBuffer(uint8_t* data, const uint32_t dataLen, const bo
     if (lastBlock)
         m_eof = true;
 
+    checkTmpBufferSpace(dataLen);
+    memcpy(m_tmpBuffer + m_tmpBufferLen, data + MAX_AV_PACKET_SIZE, dataLen);
+    m_tmpBufferLen += dataLen;
+    useTmpBuffer();
+}
+
+void MPEGStreamReader::setBufferSlices(const std::vector<DataSlice>& slices, const uint32_t dataLen,
+                                       const bool lastBlock)
+{
+    if (lastBlock)
+        m_eof = true;
+
+    checkTmpBufferSpace(dataLen);
+    for (const DataSlice& slice : slices)
+    {
+        memcpy(m_tmpBuffer + m_tmpBufferLen, slice.data, slice.size);
+        m_tmpBufferLen += slice.size;
+    }
+    useTmpBuffer();
+}
+
+void MPEGStreamReader::checkTmpBufferSpace(const uint32_t dataLen) const
+{
     if (m_tmpBufferLen + dataLen > TMP_BUFFER_SIZE)
         THROW(ERR_COMMON_SMALL_BUFFER,
               "Not enough buffer for parse video stream. Current frame num " << m_totalFrameNum)
-    memcpy(m_tmpBuffer + m_tmpBufferLen, data + MAX_AV_PACKET_SIZE, dataLen);
-    m_tmpBufferLen += dataLen;
+}
 
+void MPEGStreamReader::useTmpBuffer()
+{
     m_curPos = m_buffer = m_tmpBuffer;
     m_bufEnd = m_buffer + m_tmpBufferLen;
     m_tmpBufferLen = 0;
@@ -49,6 +49,8 @@ class MPEGStreamReader : public AbstractStreamReader
     void setAspectRatio(const VideoAspectRatio ar) { m_ar = ar; }
     int64_t getProcessedSize() override;
     void setBuffer(uint8_t* data, uint32_t dataLen, bool lastBlock = false) override;
+    [[nodiscard]] bool gathersSlices() const override { return true; }
+    void setBufferSlices(const std::vector<DataSlice>& slices, uint32_t dataLen, bool lastBlock = false) override;
     int readPacket(AVPacket& avPacket) override;
     int flushPacket(AVPacket& avPacket) override;
     [[nodiscard]] virtual unsigned getStreamWidth() const = 0;
@@ -99,6 +101,8 @@ class MPEGStreamReader : public AbstractStreamReader
     [[nodiscard]] int bufFromNAL() const;
     virtual int decodeNal(uint8_t* buff);
     void storeBufferRest();
+    void checkTmpBufferSpace(uint32_t dataLen) const;
+    void useTmpBuffer();  // parse the data gathered in m_tmpBuffer
 };
 
 #endif
@@ -14,6 +14,7 @@ using namespace std;
 
 // static const int SSIF_INTERLEAVE_BLOCKSIZE = 1024 * 1024 * 7;
 static constexpr int MAX_FRAME_SIZE = 1200000;  // 1.2m
+static constexpr uint32_t DEFAULT_READ_QUEUE_DEPTH = 32;
 
 namespace
 {
@@ -39,8 +40,11 @@ int seekDefaultTrack(const std::vector<StreamInfo>& tracks, std::string& param,
 }
 }  // namespace
 
-MuxerManager::MuxerManager(const BufferedReaderManager& readManager, AbstractMuxerFactory& factory)
-    : m_metaDemuxer(readManager), m_factory(factory)
+MuxerManager::MuxerManager(BufferedReaderManager& readManager, AbstractMuxerFactory& factory)
+    : m_readManager(readManager),
+      m_metaDemuxer(readManager),
+      m_writeBufferPool(WRITE_BUFFER_SIZE, WRITE_BUFFER_POOL_SIZE),
+      m_factory(factory)
 {
     m_asyncMode = true;
     m_fileWriter = nullptr;
@@ -66,6 +70,10 @@ MuxerManager::~MuxerManager()
 
 void MuxerManager::preinitMux(const std::string& outFileName, FileFactory* fileFactory)
 {
+    if (m_demuxMode && outFileName == STDOUT_FILE_NAME)
+        THROW(ERR_COMMON, "Demuxed tracks can't be written to stdout")
+    if (m_cutStart > 0)
+        m_metaDemuxer.seekToTime(m_cutStart);
     vector<StreamInfo>& ci = m_metaDemuxer.getCodecInfo();
     bool mvcTrackFirst = false;
     bool firstH264Track = true;
@@ -209,7 +217,8 @@ void MuxerManager::doMux(const string& outFileName, FileFactory* fileFactory)
 {
     preinitMux(outFileName, fileFactory);
 
-    m_fileWriter = new BufferedFileWriter();
+    m_fileWriter = new BufferedFileWriterPool(&m_writeBufferPool, m_writeBufferPool.capacity(), m_writeBatchSize,
+                                              m_writerThreads, m_writerPerFile);
     AVPacket avPacket;
 
     while (true)
@@ -242,13 +251,31 @@ void MuxerManager::doMux(const string& outFileName, FileFactory* fileFactory)
 
     waitForWriting();
 
-    m_mainMuxer->close();
-    if (m_subMuxer)
-        m_subMuxer->close();
+    if (!m_mainMuxer->close() || (m_subMuxer && !m_subMuxer->close()))
+        THROW(ERR_FILE_COMMON, "Can't close the output file")
+
+    if (m_writeStats)
+    {
+        const WriteStats stats = m_fileWriter->getWriteStats();
+        LTRACE(LT_INFO, 2,
+               "Output stalls: " << stats.stallCnt << ", stall time: "
+                                 << std::chrono::duration_cast<std::chrono::milliseconds>(stats.stallTime).count()
+                                 << " ms, max write queue: " << stats.maxQueueSize << " blocks, writer threads: "
+                                 << m_fileWriter->writerCount());
+    }
 
     delete m_fileWriter;
 
     m_fileWriter = nullptr;
+
+    if (m_readStats)
+    {
+        const ReadStats stats = m_readManager.getReadStats();
+        LTRACE(LT_INFO, 2,
+               "Input stalls: " << stats.stallCnt << ", stall time: "
+                                << std::chrono::duration_cast<std::chrono::milliseconds>(stats.stallTime).count()
+                                << " ms, max read-ahead: " << stats.maxBlockCnt << " blocks");
+    }
 }
 
 int MuxerManager::addStream(const string& codecName, const string& fileName, const map<string, string>& addParams)
@@ -314,15 +341,7 @@ void MuxerManager::asyncWriteBuffer(const AbstractMuxer* muxer, uint8_t* buff, c
     asyncWriteBlock(data);
 }
 
-void MuxerManager::asyncWriteBlock(const WriterData& data) const
-{
-    static constexpr int nMaxWriteQueueSize = 256 * 1024 * 1024 / DEFAULT_FILE_BLOCK_SIZE;
-    while (m_fileWriter->getQueueSize() > nMaxWriteQueueSize)
-    {
-        Process::sleep(1);
-    }
-    m_fileWriter->addWriterData(data);
-}
+void MuxerManager::asyncWriteBlock(const WriterData& data) const { m_fileWriter->push(data); }
 
 int MuxerManager::syncWriteBuffer(AbstractMuxer* muxer, const uint8_t* buff, const int len,
                                   AbstractOutputStream* dstFile) const
@@ -396,13 +415,67 @@ void MuxerManager::parseMuxOpt(const string& opts)
         {
             m_reproducibleIsoHeader = true;
         }
+        else if (paramPair[0] == "--read-ahead" && paramPair.size() > 1)
+        {
+            const vector<string> blocks = splitStr(paramPair[1].c_str(), ':');
+            const uint32_t maxBlocks = strToInt32u(blocks.back().c_str());
+            m_readManager.setReadAhead(blocks.size() > 1 ? strToInt32u(blocks[0].c_str()) : DEFAULT_READ_AHEAD_BLOCKS,
+                                       maxBlocks);
+        }
+        else if (paramPair[0] == "--direct-io")
+        {
+            m_directIo = true;
+        }
+        else if (paramPair[0] == "--writeback" && paramPair.size() > 1)
+        {
+            m_writebackWindow = std::min<uint32_t>(strToInt32u(paramPair[1].c_str()), 2048) * 1024 * 1024;
+        }
+        else if (paramPair[0] == "--read-stats")
+        {
+            m_readStats = true;
+        }
+        else if (paramPair[0] == "--write-batch" && paramPair.size() > 1)
+        {
+            m_writeBatchSize = strToInt32u(paramPair[1].c_str());
+        }
+        else if (paramPair[0] == "--writer-threads" && paramPair.size() > 1)
+        {
+            m_writerThreads = strToInt32u(paramPair[1].c_str());
+        }
+        else if (paramPair[0] == "--writer-per-file")
+        {
+            m_writerPerFile = true;
+        }
+        else if (paramPair[0] == "--write-stats")
+        {
+            m_writeStats = true;
+        }
+        else if (paramPair[0] == "--readers-per-device" && paramPair.size() > 1)
+        {
+            m_readManager.setReadersPerDevice(strToInt32u(paramPair[1].c_str()));
+        }
+        else if (paramPair[0] == "--same-device" && paramPair.size() > 1)
+        {
+            m_readManager.addDeviceGroup(splitStr(paramPair[1].c_str(), ','));
+        }
+        else if (paramPair[0] == "--keep-input-cache")
+        {
+            m_readManager.setDropInputCache(false);
+        }
+        else if (paramPair[0] == "--mmap")
+        {
+            if (!m_readManager.setMmapInput(true))
+                LTRACE(LT_WARN, 2, "Memory mapped input is not supported by the OS. Using the reader threads.");
+        }
+        else if (paramPair[0] == "--io-uring")
+        {
+            m_readManager.setReadQueueDepth(paramPair.size() > 1 ? strToInt32u(paramPair[1].c_str())
+                                                                 : DEFAULT_READ_QUEUE_DEPTH);
+        }
     }
 }
 
-void MuxerManager::waitForWriting() const
-{
-    while (!m_fileWriter->isQueueEmpty()) Process::sleep(1);
-}
+void MuxerManager::waitForWriting() const { m_fileWriter->drain(); }
 
 AbstractMuxer* MuxerManager::createMuxer() { return m_factory.newInstance(this); }
 
@@ -16,13 +16,16 @@ class MuxerManager final
     static constexpr int BLURAY_SECTOR_SIZE =
         PHYSICAL_SECTOR_SIZE * 3;  // real sector size is 2048, but M2TS frame required addition rounding by 3 blocks
 
-    MuxerManager(const BufferedReaderManager& readManager, AbstractMuxerFactory& factory);
+    MuxerManager(BufferedReaderManager& readManager, AbstractMuxerFactory& factory);
     ~MuxerManager();
 
     void setAsyncMode(const bool val) { m_asyncMode = val; }
 
     [[nodiscard]] bool isAsyncMode() const { return m_asyncMode; }
 
+    //! Output buffers of the muxers. Buffers passed to asyncWriteBuffer() are returned here once written
+    IoBufferPool& writeBufferPool() { return m_writeBufferPool; }
+
     bool openMetaFile(const std::string& fileName);
     int addStream(const std::string& codecName, const std::string& fileName,
                   const std::map<std::string, std::string>& addParams);
@@ -55,6 +58,8 @@ class MuxerManager final
     [[nodiscard]] int getExtraISOBlocks() const { return m_extraIsoBlocks; }
 
     [[nodiscard]] bool useReproducibleIsoHeader() const { return m_reproducibleIsoHeader; }
+    [[nodiscard]] bool useDirectIo() const { return m_directIo; }
+    [[nodiscard]] uint32_t writebackWindow() const { return m_writebackWindow; }
 
     enum class SubTrackMode
     {
@@ -78,10 +83,12 @@ class MuxerManager final
     // int32_t m_fileBlockSize;
     std::string m_outFileName;
     std::condition_variable reinitCond;
+    BufferedReaderManager& m_readManager;
     METADemuxer m_metaDemuxer;
     int64_t m_cutStart;
     int64_t m_cutEnd;
-    BufferedFileWriter* m_fileWriter;
+    BufferedFileWriterPool* m_fileWriter;
+    IoBufferPool m_writeBufferPool;
     AbstractMuxerFactory& m_factory;
     bool m_allowStereoMux;
     std::set<int> m_subStreamIndex;
@@ -97,6 +104,13 @@ class MuxerManager final
     bool m_bluRayMode;
     bool m_demuxMode;
     bool m_reproducibleIsoHeader = false;
+    bool m_readStats = false;
+    bool m_writeStats = false;
+    bool m_directIo = false;
+    uint32_t m_writebackWindow = 0;
+    uint32_t m_writeBatchSize = DEFAULT_WRITE_BATCH_SIZE;  // blocks
+    uint32_t m_writerThreads = DEFAULT_WRITER_THREADS;
+    bool m_writerPerFile = false;  // one writer thread per output file instead of per device
 };
 
 #endif  // _MUXER_MANAGER_H_
@@ -0,0 +1,224 @@
+#include "probeCache.h"
+
+#include <fs/directory.h>
+#include <fs/file.h>
+#include <types/types.h>
+
+#include <chrono>
+#include <cstdio>
+
+#include "crc32.h"
+#include "metaDemuxer.h"
+
+using namespace std;
+
+ProbeCache::Mode ProbeCache::m_mode = Mode::pcmUse;
+
+namespace
+{
+// increase it when the layout of an entry changes
+constexpr uint32_t PROBE_CACHE_FORMAT = 1;
+constexpr char PROBE_CACHE_MAGIC[] = "TSMP";
+
+// an entry larger than that is not a valid one
+constexpr int64_t MAX_ENTRY_SIZE = 16 * 1024 * 1024;
+
+class EntryWriter
+{
+   public:
+    void writeInt(const uint64_t val, const int bytes)
+    {
+        for (int i = 0; i < bytes; ++i) m_data.push_back(static_cast<char>(val >> (i * 8)));
+    }
+
+    void writeString(const string& val)
+    {
+        writeInt(val.size(), 4);
+        m_data += val;
+    }
+
+    [[nodiscard]] const string& data() const { return m_data; }
+
+   private:
+    string m_data;
+};
+
+class EntryReader
+{
+   public:
+    EntryReader(const string& data, const size_t pos) : m_data(data), m_pos(pos), m_error(false) {}
+
+    uint64_t readInt(const int bytes)
+    {
+        if (m_data.size() - m_pos < static_cast<size_t>(bytes))
+        {
+            m_error = true;
+            return 0;
+        }
+        uint64_t rez = 0;
+        for (int i = 0; i < bytes; ++i) rez |= static_cast<uint64_t>(static_cast<uint8_t>(m_data[m_pos++])) << (i * 8);
+        return rez;
+    }
+
+    string readString()
+    {
+        const auto len = static_cast<size_t>(readInt(4));
+        if (m_data.size() - m_pos < len)
+        {
+            m_error = true;
+            return {};
+        }
+        m_pos += len;
+        return m_data.substr(m_pos - len, len);
+    }
+
+    [[nodiscard]] bool hasError() const { return m_error; }
+    // all the data is read and there was no error
+    [[nodiscard]] bool isComplete() const { return !m_error && m_pos == m_data.size(); }
+
+   private:
+    const string& m_data;
+    size_t m_pos;
+    bool m_error;
+};
+
+string entryFileName(const string& fileName)
+{
+    const string cacheDir = getUserCacheDir();
+    if (cacheDir.empty())
+        return {};
+    const auto crc = calculateCRC32(reinterpret_cast<const uint8_t*>(fileName.data()), fileName.size());
+    return cacheDir + "tsMuxer" + getDirSeparator() + "probe" + getDirSeparator() + int32uToHex(crc) + ".probe";
+}
+
+void writeStamp(EntryWriter& writer, const FileStamp& stamp)
+{
+    writer.writeInt(stamp.size, 8);
+    writer.writeInt(stamp.modTime, 8);
+    writer.writeInt(stamp.device, 8);
+    writer.writeInt(stamp.inode, 8);
+}
+
+// the start of the entry which must match: the format, the program version and the state of the probed files
+bool entryHeader(const string& fileName, const string& depFileName, const bool calcDuration, string& header)
+{
+    EntryWriter writer;
+    FileStamp stamp{};
+    if (!getFileStamp(fileName, &stamp))
+        return false;
+    writer.writeString(PROBE_CACHE_MAGIC);
+    writer.writeInt(PROBE_CACHE_FORMAT, 4);
+    writer.writeString(TSMUXER_VERSION);
+    writer.writeString(fileName);
+    writeStamp(writer, stamp);
+    writer.writeString(depFileName);
+    stamp = {};
+    if (!depFileName.empty() && !getFileStamp(depFileName, &stamp))
+        return false;
+    writeStamp(writer, stamp);
+    writer.writeInt(calcDuration, 1);
+    header = writer.data();
+    return true;
+}
+
+bool readEntry(const string& entryName, string& data)
+{
+    File file;
+    if (!file.open(entryName.c_str(), File::ofRead | File::ofOpenExisting))
+        return false;
+    const int64_t size = file.size();
+    if (size <= 0 || size > MAX_ENTRY_SIZE)
+        return false;
+    data.resize(static_cast<size_t>(size));
+    return file.read(data.data(), static_cast<uint32_t>(size)) == size;
+}
+}  // namespace
+
+bool ProbeCache::load(const string& fileName, const string& depFileName, const bool calcDuration,
+                      DetectStreamRez& rez)
+{
+    if (m_mode != Mode::pcmUse || isPipeInput(fileName.c_str()))
+        return false;
+    const string entryName = entryFileName(fileName);
+    string header;
+    string data;
+    if (entryName.empty() || !entryHeader(fileName, depFileName, calcDuration, header) ||
+        !readEntry(entryName, data) || data.compare(0, header.size(), header) != 0)
+        return false;
+
+    EntryReader reader(data, header.size());
+    DetectStreamRez entry;
+    entry.fileDurationNano = static_cast<int64_t>(reader.readInt(8));
+    const auto chapterCnt = static_cast<uint32_t>(reader.readInt(4));
+    for (uint32_t i = 0; i < chapterCnt && !reader.hasError(); ++i)
+    {
+        const auto start = static_cast<int64_t>(reader.readInt(8));
+        entry.chapters.emplace_back(start, reader.readString());
+    }
+    const auto streamCnt = static_cast<uint32_t>(reader.readInt(4));
+    for (uint32_t i = 0; i < streamCnt && !reader.hasError(); ++i)
+    {
+        CheckStreamRez stream;
+        stream.codecInfo.codecID = static_cast<int>(reader.readInt(4));
+        stream.codecInfo.displayName = reader.readString();
+        stream.codecInfo.programName = reader.readString();
+        stream.streamDescr = reader.readString();
+        stream.lang = reader.readString();
+        stream.trackID = static_cast<int32_t>(reader.readInt(4));
+        stream.delay = static_cast<int64_t>(reader.readInt(8));
+        const auto flags = static_cast<uint8_t>(reader.readInt(1));
+        stream.multiSubStream = flags & 1;
+        stream.isSecondary = flags & 2;
+        stream.unused = flags & 4;
+        entry.streams.push_back(stream);
+    }
+    if (!reader.isComplete())
+        return false;
+    rez = entry;
+    return true;
+}
+
+void ProbeCache::store(const string& fileName, const string& depFileName, const bool calcDuration,
+                       const DetectStreamRez& rez)
+{
+    if (m_mode == Mode::pcmOff || isPipeInput(fileName.c_str()))
+        return;
+    const string entryName = entryFileName(fileName);
+    string header;
+    if (entryName.empty() || !entryHeader(fileName, depFileName, calcDuration, header))
+        return;
+
+    EntryWriter writer;
+    writer.writeInt(rez.fileDurationNano, 8);
+    writer.writeInt(rez.chapters.size(), 4);
+    for (const AVChapter& chapter : rez.chapters)
+    {
+        writer.writeInt(chapter.start, 8);
+        writer.writeString(chapter.cTitle);
+    }
+    writer.writeInt(rez.streams.size(), 4);
+    for (const CheckStreamRez& stream : rez.streams)
+    {
+        writer.writeInt(stream.codecInfo.codecID, 4);
+        writer.writeString(stream.codecInfo.displayName);
+        writer.writeString(stream.codecInfo.programName);
+        writer.writeString(stream.streamDescr);
+        writer.writeString(stream.lang);
+        writer.writeInt(stream.trackID, 4);
+        writer.writeInt(stream.delay, 8);
+        writer.writeInt(stream.multiSubStream | stream.isSecondary << 1 | stream.unused << 2, 1);
+    }
+
+    // the entry is written under a temporary name, so a concurrent probe never reads a partial one
+    const string tmpName =
+        entryName + '.' + int64ToStr(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+    File file;
+    if (!file.open(tmpName.c_str(), File::ofWrite))
+        return;
+    const string data = header + writer.data();
+    const bool written = file.write(data.data(), static_cast<uint32_t>(data.size())) == static_cast<int>(data.size());
+    file.close();
+    if (!written || (rename(tmpName.c_str(), entryName.c_str()) != 0 &&
+                     (!deleteFile(entryName) || rename(tmpName.c_str(), entryName.c_str()) != 0)))
+        deleteFile(tmpName);
+}
@@ -0,0 +1,37 @@
+#ifndef PROBE_CACHE_H_
+#define PROBE_CACHE_H_
+
+#include <string>
+
+struct DetectStreamRez;
+
+//! Results of the track detection kept on disk between the runs of the program
+/*!
+        An entry is found by the name of the probed file. It is used while the size, the modification time and the
+        inode of the file and of the Blu-ray clip info file it depends on are the same, and only by the version of
+        the program which wrote it. The cache is stored in the user's cache directory.
+*/
+class ProbeCache
+{
+   public:
+    enum class Mode
+    {
+        pcmUse,      // use the stored results and store the new ones
+        pcmRefresh,  // detect the tracks again and replace the stored results
+        pcmOff       // neither read nor write the cache
+    };
+
+    static void setMode(const Mode mode) { m_mode = mode; }
+    [[nodiscard]] static Mode getMode() { return m_mode; }
+
+    //! Get the stored results for a file. depFileName is the clip info file of the stream or empty
+    static bool load(const std::string& fileName, const std::string& depFileName, bool calcDuration,
+                     DetectStreamRez& rez);
+    static void store(const std::string& fileName, const std::string& depFileName, bool calcDuration,
+                      const DetectStreamRez& rez);
+
+   private:
+    static Mode m_mode;
+};
+
+#endif
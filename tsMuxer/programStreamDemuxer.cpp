@@ -11,12 +11,12 @@ static constexpr int LPCM_FREQS[4] = {48000, 96000, 44100, 32000};
 
 // #define min(a,b) a<=b?a:b
 
-ProgramStreamDemuxer::ProgramStreamDemuxer(const BufferedReaderManager& readManager)
+ProgramStreamDemuxer::ProgramStreamDemuxer(const BufferedReaderManager& readManager, const char* streamName)
     : m_tmpBuffer{}, m_readManager(readManager), m_dataProcessed(0)
 {
     memset(m_psm_es_type, 0, sizeof(m_psm_es_type));
     memset(m_lpcpHeaderAdded, 0, sizeof(m_lpcpHeaderAdded));
-    m_bufferedReader = m_readManager.getReader(m_streamName.c_str());
+    m_bufferedReader = m_readManager.getReader(streamName);
     m_readerID = m_bufferedReader->createReader(MAX_PES_HEADER_SIZE);
     m_lastReadRez = 0;
     m_lastPesLen = 0;
@@ -28,10 +28,7 @@ ProgramStreamDemuxer::ProgramStreamDemuxer(const BufferedReaderManager& readMana
 
 void ProgramStreamDemuxer::setFileIterator(FileNameIterator* itr)
 {
-    const auto br = dynamic_cast<BufferedReader*>(m_bufferedReader);
-    if (br)
-        br->setFileIterator(itr, m_readerID);
-    else if (itr != nullptr)
+    if (!m_bufferedReader->setFileIterator(itr, m_readerID) && itr != nullptr)
         THROW(ERR_COMMON, "Can not set file iterator. Reader does not support bufferedReader interface.")
 }
 
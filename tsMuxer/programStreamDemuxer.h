@@ -12,7 +12,7 @@ class ProgramStreamDemuxer final : public AbstractDemuxer
    public:
     static constexpr int MAX_PES_HEADER_SIZE = 1018;  // buffer for PES header and program stream map
 
-    ProgramStreamDemuxer(const BufferedReaderManager& readManager);
+    ProgramStreamDemuxer(const BufferedReaderManager& readManager, const char* streamName);
     void openFile(const std::string& streamName) override;
     static int readPacket(AVPacket& avPacket) { return 0; }
     ~ProgramStreamDemuxer() override;
@@ -44,6 +44,19 @@ void SimplePacketizerReader::doMplsCorrection()
     }
 }
 
+void SimplePacketizerReader::skipMplsTime(const int64_t time)
+{
+    if (m_curMplsIndex == -1)
+        return;
+    m_lastMplsTime -= static_cast<double>(time);
+    while (m_lastMplsTime < mplsEps && m_curMplsIndex < static_cast<int>(m_mplsInfo.size() - 1))
+    {
+        m_curMplsIndex++;
+        m_lastMplsTime +=
+            (m_mplsInfo[m_curMplsIndex].OUT_time - m_mplsInfo[m_curMplsIndex].IN_time) * (INTERNAL_PTS_FREQ / 45000.0);
+    }
+}
+
 void SimplePacketizerReader::setBuffer(uint8_t* data, const uint32_t dataLen, bool lastBlock)
 {
     if (static_cast<size_t>(m_tmpBufferLen + dataLen) > m_tmpBuffer.size())
@@ -52,7 +65,24 @@ void SimplePacketizerReader::setBuffer(uint8_t* data, const uint32_t dataLen, bo
     if (!m_tmpBuffer.empty())
         memcpy(m_tmpBuffer.data() + m_tmpBufferLen, data + MAX_AV_PACKET_SIZE, dataLen);
     m_tmpBufferLen += dataLen;
+    useTmpBuffer();
+}
+
+void SimplePacketizerReader::setBufferSlices(const std::vector<DataSlice>& slices, const uint32_t dataLen, bool)
+{
+    if (static_cast<size_t>(m_tmpBufferLen + dataLen) > m_tmpBuffer.size())
+        m_tmpBuffer.resize(m_tmpBufferLen + dataLen);
 
+    for (const DataSlice& slice : slices)
+    {
+        memcpy(m_tmpBuffer.data() + m_tmpBufferLen, slice.data, slice.size);
+        m_tmpBufferLen += slice.size;
+    }
+    useTmpBuffer();
+}
+
+void SimplePacketizerReader::useTmpBuffer()
+{
     if (!m_tmpBuffer.empty())
         m_curPos = m_buffer = m_tmpBuffer.data();
     else
@@ -15,6 +15,8 @@ class SimplePacketizerReader : public AbstractStreamReader
     int readPacket(AVPacket& avPacket) override;
     int flushPacket(AVPacket& avPacket) override;
     void setBuffer(uint8_t* data, uint32_t dataLen, bool lastBlock = false) override;
+    [[nodiscard]] bool gathersSlices() const override { return true; }
+    void setBufferSlices(const std::vector<DataSlice>& slices, uint32_t dataLen, bool lastBlock = false) override;
     int64_t getProcessedSize() override;
     virtual CheckStreamRez checkStream(uint8_t* buffer, int len, ContainerType containerType, int containerDataType,
                                        int containerStreamIndex);
@@ -33,6 +35,8 @@ class SimplePacketizerReader : public AbstractStreamReader
         else
             m_curMplsIndex = -1;
     }
+    // the stream is read from the given time of the playlist, the play items before it are passed
+    void skipMplsTime(int64_t time);
 
     // split point can be on any frame
     virtual bool isIFrame(AVPacket* packet) { return true; }
@@ -64,6 +68,9 @@ class SimplePacketizerReader : public AbstractStreamReader
     int m_containerStreamIndex;
     std::vector<MPLSPlayItem> m_mplsInfo;
     void doMplsCorrection();
+
+   private:
+    void useTmpBuffer();  // parse the data gathered in m_tmpBuffer
 };
 
 #endif
@@ -152,7 +152,7 @@ void SingleFileMuxer::intAddStream(const std::string& streamName, const std::str
         fileName += itr->second;
     }
 
-    auto streamInfo = new StreamInfo(static_cast<unsigned>(DEFAULT_FILE_BLOCK_SIZE));
+    auto streamInfo = new StreamInfo(m_owner->writeBufferPool().acquire());
     streamInfo->m_fileName = fileName + fileExt;
     if (streamInfo->m_fileName.size() > 254)
         LTRACE(LT_ERROR, 2, "Error: File name too long.");
@@ -175,9 +175,16 @@ void SingleFileMuxer::openDstFile()
         si->m_fileName = dir + si->m_fileName;
         if (!si->m_file.open(si->m_fileName.c_str(), File::ofWrite, systemFlags))
             THROW(ERR_CANT_CREATE_FILE, "Can't create output file " << si->m_fileName)
+        si->m_file.setWriteback(m_owner->writebackWindow());
+        si->m_file.preallocate(estimatedStreamSize());
     }
 }
 
+int64_t SingleFileMuxer::estimatedStreamSize() const
+{
+    return m_streamInfo.empty() ? 0 : m_owner->totalSize() / static_cast<int64_t>(m_streamInfo.size());
+}
+
 void SingleFileMuxer::writeOutBuffer(StreamInfo* streamInfo)
 {
     constexpr int blockSize = DEFAULT_FILE_BLOCK_SIZE;
@@ -186,7 +193,7 @@ void SingleFileMuxer::writeOutBuffer(StreamInfo* streamInfo)
         constexpr int toFileLen = blockSize & 0xffff0000;
         if (m_owner->isAsyncMode())
         {
-            const auto newBuf = new uint8_t[blockSize + MAX_AV_PACKET_SIZE];
+            const auto newBuf = m_owner->writeBufferPool().acquire();
             memcpy(newBuf, streamInfo->m_buffer + toFileLen, streamInfo->m_bufLen - toFileLen);
             m_owner->asyncWriteBuffer(this, streamInfo->m_buffer, toFileLen, &streamInfo->m_file);
             streamInfo->m_buffer = newBuf;
@@ -226,6 +233,8 @@ void SingleFileMuxer::writeOutBuffer(StreamInfo* streamInfo)
 #endif
         if (!streamInfo->m_file.open(streamInfo->m_fileName.c_str(), File::ofWrite + systemFlags))
             THROW(ERR_COMMON, "Can't open file " << streamInfo->m_fileName)
+        streamInfo->m_file.setWriteback(m_owner->writebackWindow());
+        streamInfo->m_file.preallocate(std::min<int64_t>(estimatedStreamSize(), 0xffff0000ul));
         lpcmReader->setFirstFrame(true);
         streamInfo->m_totalWrited = 0;
     }
@@ -265,7 +274,7 @@ bool SingleFileMuxer::doFlush()
         {
             if (lastBlockSize > 0)
             {
-                const auto newBuff = new uint8_t[lastBlockSize];
+                const auto newBuff = m_owner->writeBufferPool().acquire();
                 memcpy(newBuff, streamInfo->m_buffer + roundBufLen, lastBlockSize);
                 m_owner->asyncWriteBuffer(this, streamInfo->m_buffer, roundBufLen, &streamInfo->m_file);
                 streamInfo->m_buffer = newBuff;
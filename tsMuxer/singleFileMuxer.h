@@ -5,6 +5,7 @@
 
 #include "abstractMuxer.h"
 #include "avPacket.h"
+#include "bufferedFileWriter.h"
 
 class SingleFileMuxer final : public AbstractMuxer
 {
@@ -23,6 +24,7 @@ class SingleFileMuxer final : public AbstractMuxer
 
    private:
     static constexpr int ADD_DATA_SIZE = 2048;
+    static_assert(WRITE_BUFFER_SIZE >= DEFAULT_FILE_BLOCK_SIZE + MAX_AV_PACKET_SIZE + ADD_DATA_SIZE);
     struct StreamInfo
     {
         File m_file;
@@ -34,10 +36,9 @@ class SingleFileMuxer final : public AbstractMuxer
         int m_bufLen;
         uint64_t m_totalWrited;
         AbstractStreamReader* m_codecReader;
-        StreamInfo(const int blockSize)
+        StreamInfo(uint8_t* buffer)
         {
-            m_buffer = new uint8_t[blockSize + MAX_AV_PACKET_SIZE +
-                                   ADD_DATA_SIZE];  // reserv extra ADD_DATA_SIZE bytes for stream additional data
+            m_buffer = buffer;  // a write buffer, it reserves extra ADD_DATA_SIZE bytes for stream additional data
             m_bufLen = 0;
             m_dts = -1;
             m_pts = -1;
@@ -45,7 +46,7 @@ class SingleFileMuxer final : public AbstractMuxer
             m_totalWrited = 0;
             m_part = 1;
         }
-        ~StreamInfo() { delete[] m_buffer; }
+        ~StreamInfo() { freeIoBuffer(m_buffer); }
     };
     int m_lastIndex;
     std::map<std::string, int> m_trackNameTmp;
@@ -53,6 +54,8 @@ class SingleFileMuxer final : public AbstractMuxer
     // std::map<int, File> m_file;
     std::map<int, StreamInfo*> m_streamInfo;
     void writeOutBuffer(StreamInfo* streamInfo);
+    // initial disk space reserved for an output file. The file system extends it if a stream needs more
+    [[nodiscard]] int64_t estimatedStreamSize() const;
 };
 
 class SingleFileMuxerFactory final : public AbstractMuxerFactory
@@ -1,8 +1,15 @@
 #include "tsDemuxer.h"
 
+#include <fs/directory.h>
 #include <fs/systemlog.h>
 
+#include <algorithm>
+
 #include "abstractStreamReader.h"
+#include "bufferedFileReader.h"
+#include "metaDemuxer.h"
+#include "nalUnits.h"
+#include "tsPacketScan.h"
 #include "vodCoreException.h"
 #include "vod_common.h"
 
@@ -47,6 +54,7 @@ TSDemuxer::TSDemuxer(const BufferedReaderManager& readManager, const char* strea
     m_curFileNum = 0;
     m_lastPCRVal = -1;
     m_nonMVCVideoFound = false;
+    m_fileIterator = nullptr;
     m_firstDemuxCall = true;
     memset(m_acceptedPidCache, 0, sizeof(m_acceptedPidCache));
 }
@@ -131,11 +139,7 @@ void TSDemuxer::getTrackList(std::map<int32_t, TrackInfo>& trackList)
                         nonProcPMTPid.erase(pid);
                         if (nonProcPMTPid.empty() && !mvcContinueExpected())
                         {  // all pmt pids processed
-                            auto br = dynamic_cast<BufferedFileReader*>(m_bufferedReader);
-                            if (br)
-                                br->incSeek(m_readerID, -static_cast<int64_t>(totalReadedBytes));
-                            else
-                                THROW(ERR_COMMON, "Function TSDemuxer::getTrackList required bufferedReader!")
+                            m_bufferedReader->incSeek(m_readerID, -static_cast<int64_t>(totalReadedBytes));
                             return;
                         }
                     }
@@ -149,11 +153,7 @@ void TSDemuxer::getTrackList(std::map<int32_t, TrackInfo>& trackList)
         }
     }
 
-    auto br = dynamic_cast<BufferedFileReader*>(m_bufferedReader);
-    if (br)
-        br->incSeek(m_readerID, -static_cast<int64_t>(totalReadedBytes));
-    else
-        THROW(ERR_COMMON, "Function TSDemuxer::getTrackList required bufferedReader!")
+    m_bufferedReader->incSeek(m_readerID, -static_cast<int64_t>(totalReadedBytes));
 }
 
 bool TSDemuxer::isVideoPID(const StreamType streamType)
@@ -195,7 +195,8 @@ int TSDemuxer::simpleDemuxBlock(DemuxedData& demuxedData, const PIDSet& accepted
 {
     if (m_firstDemuxCall)
     {
-        for (const int acceptedPID : acceptedPIDs) m_acceptedPidCache[acceptedPID] = 1;
+        for (const int acceptedPID : acceptedPIDs)
+            m_acceptedPidCache[acceptedPID] = m_pesStartPids.find(acceptedPID) != m_pesStartPids.end() ? 2 : 1;
         m_firstDemuxCall = false;
     }
 
@@ -205,6 +206,8 @@ int TSDemuxer::simpleDemuxBlock(DemuxedData& demuxedData, const PIDSet& accepted
     int lastPid = -1;
 
     for (int acceptedPID : acceptedPIDs) demuxedData[acceptedPID];
+    // the payload of the previous call is still in the reader's block which is reused by the next read
+    for (auto& streamData : demuxedData) streamData.second.gather();
 
     discardSize = 0;
     uint32_t readedBytes;
@@ -307,7 +310,9 @@ int TSDemuxer::simpleDemuxBlock(DemuxedData& demuxedData, const PIDSet& accepted
         }
     }
 
-    for (m_curPos = data; m_curPos <= lastFrameAddr; m_curPos += TS_FRAME_SIZE)
+    const int stride = m_m2tsMode ? TS_FRAME_SIZE + 4 : TS_FRAME_SIZE;
+    TSPacketHeader headers[TS_SCAN_BATCH];
+    for (m_curPos = data; m_curPos <= lastFrameAddr;)
     {
         if (!m_m2tsHdrDiscarded && m_m2tsMode)
         {
@@ -326,103 +331,103 @@ int TSDemuxer::simpleDemuxBlock(DemuxedData& demuxedData, const PIDSet& accepted
         }
         m_m2tsHdrDiscarded = false;
 
-        const auto tsPacket = reinterpret_cast<TSPacket*>(m_curPos);
-        int pid = tsPacket->getPID();
-        discardSize += TS_FRAME_SIZE;
-
-        // pcrFrames++;
-
-        if (tsPacket->afExists)
-        {
-            if (tsPacket->adaptiveField.pcrExist)
-            {
-                // if (prevPCR == -1)
-                //	prevPCR = tsPacket->adaptiveField.getPCR33();
-
-                // prevPCR = tsPacket->adaptiveField.getPCR33();
-                // LTRACE(LT_INFO, 2, "pcr: " << prevPCR - 55729419ll);
-                // pcrFrames = 0;
-            }
-        }
-
-        uint8_t* frameData = m_curPos + tsPacket->getHeaderSize();
-        const bool pesStartCode = frameData[0] == 0 && frameData[1] == 0 && frameData[2] == 1 && tsPacket->payloadStart;
-        if (pesStartCode)
+        // the packets which follow without a gap are checked together, the search above is only needed to resync
+        const auto maxCount =
+            static_cast<int>(std::min<int64_t>((lastFrameAddr - m_curPos) / stride + 1, TS_SCAN_BATCH));
+        const int count = scanTSPackets(m_curPos, maxCount, stride, headers);
+        for (int i = 0; i < count; ++i)
         {
-            const auto pesPacket = reinterpret_cast<PESPacket*>(frameData);
-            auto streamInfo = m_pmt.pidList.find(pid);
+            uint8_t* packet = m_curPos + i * stride;
+            const TSPacketHeader& header = headers[i];
+            const int pid = header.pid;
+            discardSize += TS_FRAME_SIZE;
+            if (i > 0 && m_m2tsMode)
+                discardSize += 4;
 
-            if ((pesPacket->flagsLo & 0x80) == 0x80)
+            uint8_t* frameData = packet + header.headerSize;
+            const bool pesStartCode =
+                header.payloadStart && frameData[0] == 0 && frameData[1] == 0 && frameData[2] == 1;
+            if (pesStartCode)
             {
-                const int64_t curPts = pesPacket->getPts();
-                int64_t curDts = curPts;
+                const auto pesPacket = reinterpret_cast<PESPacket*>(frameData);
+                auto streamInfo = m_pmt.pidList.find(pid);
 
-                if ((pesPacket->flagsLo & 0xc0) == 0xc0)
-                    curDts = pesPacket->getDts();
+                if ((pesPacket->flagsLo & 0x80) == 0x80)
+                {
+                    const int64_t curPts = pesPacket->getPts();
+                    int64_t curDts = curPts;
 
-                if (m_lastPTS == -1 || curPts > m_lastPTS)
-                    m_lastPTS = curPts;
+                    if ((pesPacket->flagsLo & 0xc0) == 0xc0)
+                        curDts = pesPacket->getDts();
 
-                if (m_firstPTS == -1 || curPts < m_firstPTS)
-                    m_firstPTS = curPts;
+                    if (m_lastPTS == -1 || curPts > m_lastPTS)
+                        m_lastPTS = curPts;
 
-                if (streamInfo != m_pmt.pidList.end() && isVideoPID(streamInfo->second.m_streamType))
-                {
-                    if (m_firstVideoPTS == -1 || curPts < m_firstVideoPTS)
-                        m_firstVideoPTS = curPts;
-                    if (curPts > m_lastVideoPTS)
-                        m_lastVideoPTS = curPts;
-                    if (m_lastVideoDTS == -1)
-                        m_lastVideoDTS = curDts;
-                    if (m_videoDtsGap == -1 && curDts > m_lastVideoDTS)
-                        m_videoDtsGap = curDts - m_lastVideoDTS;
-                }
+                    if (m_firstPTS == -1 || curPts < m_firstPTS)
+                        m_firstPTS = curPts;
 
-                if (m_firstPtsTime.find(pid) == m_firstPtsTime.end() ||
-                    (m_curFileNum == 0 && curPts < m_firstPtsTime[pid]))
-                    m_firstPtsTime[pid] = curPts;
-            }
+                    if (streamInfo != m_pmt.pidList.end() && isVideoPID(streamInfo->second.m_streamType))
+                    {
+                        if (m_firstVideoPTS == -1 || curPts < m_firstVideoPTS)
+                            m_firstVideoPTS = curPts;
+                        if (curPts > m_lastVideoPTS)
+                            m_lastVideoPTS = curPts;
+                        if (m_lastVideoDTS == -1)
+                            m_lastVideoDTS = curDts;
+                        if (m_videoDtsGap == -1 && curDts > m_lastVideoDTS)
+                            m_videoDtsGap = curDts - m_lastVideoDTS;
+                    }
 
-            if (streamInfo != m_pmt.pidList.end() &&
-                streamInfo->second.m_streamType != StreamType::SUB_PGS)  // demux PGS with PES headers
-                frameData += pesPacket->getHeaderLength();
-            else
-            {
-                const int64_t ptsBase = m_firstVideoPTS != -1 ? m_firstVideoPTS : m_firstPTS;
-                if ((pesPacket->flagsLo & 0xc0) == 0xc0)
-                {
-                    const int64_t pts = pesPacket->getPts() - ptsBase + m_prevFileLen;
-                    const int64_t dts = pesPacket->getDts() - ptsBase + m_prevFileLen;
-                    pesPacket->setPtsAndDts(pts, dts);
+                    if (m_firstPtsTime.find(pid) == m_firstPtsTime.end() ||
+                        (m_curFileNum == 0 && curPts < m_firstPtsTime[pid]))
+                        m_firstPtsTime[pid] = curPts;
                 }
-                else if ((pesPacket->flagsLo & 0x80) == 0x80)
+
+                if (streamInfo != m_pmt.pidList.end() &&
+                    streamInfo->second.m_streamType != StreamType::SUB_PGS)  // demux PGS with PES headers
+                    frameData += pesPacket->getHeaderLength();
+                else
                 {
-                    const int64_t pts = pesPacket->getPts() - ptsBase + m_prevFileLen;
-                    pesPacket->setPts(pts);
+                    const int64_t ptsBase = m_firstVideoPTS != -1 ? m_firstVideoPTS : m_firstPTS;
+                    if ((pesPacket->flagsLo & 0xc0) == 0xc0)
+                    {
+                        const int64_t pts = pesPacket->getPts() - ptsBase + m_prevFileLen;
+                        const int64_t dts = pesPacket->getDts() - ptsBase + m_prevFileLen;
+                        pesPacket->setPtsAndDts(pts, dts);
+                    }
+                    else if ((pesPacket->flagsLo & 0x80) == 0x80)
+                    {
+                        const int64_t pts = pesPacket->getPts() - ptsBase + m_prevFileLen;
+                        pesPacket->setPts(pts);
+                    }
                 }
             }
-        }
-
-        // if (acceptedPIDs.find(pid) == acceptedPIDs.end())
-        if (!m_acceptedPidCache[pid])
-            continue;
 
-        const int64_t payloadLen = TS_FRAME_SIZE - (frameData - m_curPos);
-        if (payloadLen > 0)
-        {
-            if (pid != lastPid)
+            if (!m_acceptedPidCache[pid])
+                continue;
+            if (m_acceptedPidCache[pid] == 2)
             {
-                vect = &demuxedData[pid];
-                lastPid = pid;
+                // the track is read from its first PES header after a seek
+                if (!pesStartCode)
+                    continue;
+                m_acceptedPidCache[pid] = 1;
             }
-            if (vect != nullptr)
+
+            const int64_t payloadLen = TS_FRAME_SIZE - (frameData - packet);
+            if (payloadLen > 0)
             {
-                vect->grow(payloadLen);
-                uint8_t* dst = vect->data() + vect->size() - payloadLen;
-                memcpy(dst, frameData, payloadLen);
+                if (pid != lastPid)
+                {
+                    vect = &demuxedData[pid];
+                    lastPid = pid;
+                }
+                if (vect != nullptr)
+                    vect->appendRef(frameData, payloadLen);
             }
+            discardSize -= payloadLen;
         }
-        discardSize -= payloadLen;
+        // the next packet starts after the M2TS header, which is skipped at the top of the loop
+        m_curPos += (count - 1) * stride + TS_FRAME_SIZE;
     }
     if (m_curPos < data + readedBytes)
     {
@@ -467,10 +472,8 @@ int64_t TSDemuxer::getDemuxedSize() { return m_dataProcessed; }
 
 void TSDemuxer::setFileIterator(FileNameIterator* itr)
 {
-    const auto br = dynamic_cast<BufferedFileReader*>(m_bufferedReader);
-    if (br)
-        br->setFileIterator(itr, m_readerID);
-    else if (itr != nullptr)
+    m_fileIterator = itr;
+    if (!m_bufferedReader->setFileIterator(itr, m_readerID) && itr != nullptr)
         THROW(ERR_COMMON, "Can not set file iterator. Reader does not support bufferedReader interface.")
 }
 
@@ -555,3 +558,498 @@ int64_t getTSDuration(const char* fileName)
 }
 
 int64_t TSDemuxer::getFileDurationNano() const { return getTSDuration(m_streamName.c_str()) * 1000000000ll / 90000ll; }
+
+namespace
+{
+// the input is read by the chunks of that size while looking for the start of a seek
+constexpr int SEEK_READ_SIZE = 1024 * 1024;
+// the start of a clip which is scanned for the tracks and their first timestamps
+constexpr int64_t SEEK_HEAD_SCAN_SIZE = 16 * 1024 * 1024;
+// the end of a clip which is scanned for its last video frame
+constexpr int64_t SEEK_TAIL_SCAN_SIZE = 4 * 1024 * 1024;
+// the data after a seek point which must contain the first frame of each track
+constexpr int64_t MAX_SEEK_SCAN_SIZE = 32 * 1024 * 1024;
+// the number of the seek points tried before the input is read from the start
+constexpr int MAX_SEEK_TRIES = 8;
+// the start of a video frame checked for the parameter sets and the key picture
+constexpr size_t KEY_FRAME_PROBE_SIZE = 16 * 1024;
+
+// the difference of two 33 bit timestamps, which may wrap around
+int64_t ptsDiff(const int64_t next, const int64_t cur)
+{
+    int64_t rez = (next - cur) & 0x1ffffffffLL;
+    if (rez >= 0x100000000LL)
+        rez -= 0x200000000LL;
+    return rez;
+}
+
+// call func for each TS packet and its file offset from pos, until it returns false or maxSize bytes are read
+template <typename Func>
+void forEachTSPacket(const File& file, const int64_t pos, const int64_t maxSize, const int frameSize, Func func)
+{
+    std::vector<uint8_t> buffer(SEEK_READ_SIZE - SEEK_READ_SIZE % frameSize);
+    if (file.seek(pos, File::SeekMethod::smBegin) != pos)
+        return;
+    for (int64_t offset = pos; offset < pos + maxSize;)
+    {
+        const int len = file.read(buffer.data(), static_cast<uint32_t>(buffer.size()));
+        if (len < frameSize)
+            return;
+        for (int i = 0; i + frameSize <= len; i += frameSize, offset += frameSize)
+        {
+            const auto tsPacket = reinterpret_cast<TSPacket*>(buffer.data() + i + frameSize - TS_FRAME_SIZE);
+            if (tsPacket->syncByte == TSPacket::TS_FRAME_SYNC_BYTE && !func(tsPacket, offset))
+                return;
+        }
+    }
+}
+
+uint8_t* getPayload(TSPacket* tsPacket) { return reinterpret_cast<uint8_t*>(tsPacket) + tsPacket->getHeaderSize(); }
+
+bool isPesStart(TSPacket* tsPacket)
+{
+    const uint8_t* payload = getPayload(tsPacket);
+    return tsPacket->payloadStart &&
+           tsPacket->getHeaderSize() + PESPacket::HEADER_SIZE + PESPacket::PTS_SIZE <= TS_FRAME_SIZE &&
+           payload[0] == 0 && payload[1] == 0 && payload[2] == 1;
+}
+
+// the PTS of the PES packet which starts in the TS packet or -1 if it has no PTS
+int64_t getPesPts(TSPacket* tsPacket)
+{
+    const auto pesPacket = reinterpret_cast<PESPacket*>(getPayload(tsPacket));
+    return (pesPacket->flagsLo & 0x80) == 0x80 ? pesPacket->getPts() : -1;
+}
+
+// the video frame is a key picture preceded by the parameter sets, so the codec reader may start from it
+bool isKeyFrame(const StreamType streamType, uint8_t* data, uint8_t* end)
+{
+    if (streamType != StreamType::VIDEO_H264 && streamType != StreamType::VIDEO_H265 &&
+        streamType != StreamType::VIDEO_MPEG2)
+        return false;
+    bool paramSets = false;
+    for (uint8_t* nal = NALUnit::findNextNAL(data, end); nal < end; nal = NALUnit::findNextNAL(nal, end))
+    {
+        if (streamType == StreamType::VIDEO_H264)
+        {
+            const int nalType = *nal & 0x1f;
+            if (nalType == 7)  // SPS
+                paramSets = true;
+            else if (nalType == 5)  // IDR slice
+                return paramSets;
+            else if (nalType == 1)  // non-IDR slice
+                return false;
+        }
+        else if (streamType == StreamType::VIDEO_H265)
+        {
+            const int nalType = (*nal >> 1) & 0x3f;
+            if (nalType == 33)  // SPS
+                paramSets = true;
+            else if (nalType >= 16 && nalType <= 21)  // IRAP slice
+                return paramSets;
+            else if (nalType < 16)  // other slices
+                return false;
+        }
+        else if (*nal == 0xb3)  // MPEG-2 sequence header
+            paramSets = true;
+        else if (*nal == 0x00 && nal + 2 < end)  // MPEG-2 picture header
+            return paramSets && ((nal[2] >> 3) & 7) == 1;
+    }
+    return false;
+}
+
+bool loadClipInfo(const std::string& fileName, CLPIParser& clpi)
+{
+    if (!isM2TSExt(fileName))
+        return false;
+    const string clpiFileName =
+        METADemuxer::findBluRayFile(extractFileDir(fileName), "CLIPINF", extractFileName(fileName) + ".clpi");
+    return !clpiFileName.empty() && clpi.parse(clpiFileName.c_str());
+}
+
+// the packets of a M2TS file have the 4 bytes header, a file with any extension may have it
+int getFrameSize(const File& file, const bool m2tsMode)
+{
+    if (m2tsMode)
+        return TS_FRAME_SIZE + 4;
+    uint8_t buffer[TS_FRAME_SIZE + 5]{};
+    if (file.seek(0, File::SeekMethod::smBegin) != 0 || file.read(buffer, sizeof(buffer)) != sizeof(buffer))
+        return TS_FRAME_SIZE;
+    const bool m2tsFrames = buffer[0] != 0x47 && buffer[4] == 0x47 && buffer[TS_FRAME_SIZE + 4] == 0x47;
+    return m2tsFrames ? TS_FRAME_SIZE + 4 : TS_FRAME_SIZE;
+}
+
+// the tracks of a clip and their timestamps in 90KHz clock
+struct ClipInfo
+{
+    int frameSize = TS_FRAME_SIZE;
+    int64_t fileSize = 0;
+    TS_program_map_section pmt;
+    std::map<int, int64_t> firstPts;  // the PTS of the first PES packet of each track
+    std::map<int, int64_t> firstDts;
+    std::map<int, int64_t> frameLen;  // the DTS difference of the first PES packets of each track
+    std::map<int, int64_t> lastPts;   // the highest PTS of each track
+    int64_t minPts = -1;
+    int64_t maxPts = -1;
+    int64_t minVideoPts = -1;
+    int64_t maxVideoPts = -1;
+    int64_t clpiDuration = -1;  // the duration from the clip info file of a Blu-ray clip
+
+    [[nodiscard]] bool isVideo(const int pid) const
+    {
+        const auto itr = pmt.pidList.find(pid);
+        return itr != pmt.pidList.end() && TSDemuxer::isVideoPID(itr->second.m_streamType);
+    }
+
+    // the time the stream reader counts for the track in the clip, or -1 if it's unknown
+    [[nodiscard]] int64_t getTrackDuration(const int pid) const
+    {
+        if (clpiDuration > 0)
+            return clpiDuration;
+        const auto first = firstPts.find(pid);
+        const auto last = lastPts.find(pid);
+        const auto len = frameLen.find(pid);
+        if (first == firstPts.end() || last == lastPts.end() || len == frameLen.end())
+            return -1;
+        return ptsDiff(last->second, first->second) + len->second;
+    }
+
+    // the time the demuxer counts for the clip, from the first to the last video frame
+    [[nodiscard]] int64_t getDuration() const
+    {
+        if (clpiDuration > 0)
+            return clpiDuration;
+        if (minVideoPts == -1)
+            return ptsDiff(maxPts, minPts);
+        int64_t videoFrameLen = 0;
+        for (const auto& [pid, len] : frameLen)
+            if (isVideo(pid))
+                videoFrameLen = len;
+        return ptsDiff(maxVideoPts, minVideoPts) + videoFrameLen;
+    }
+
+    void addPes(TSPacket* tsPacket)
+    {
+        const int pid = tsPacket->getPID();
+        const int64_t pts = getPesPts(tsPacket);
+        if (pts == -1)
+            return;
+        const auto pesPacket = reinterpret_cast<PESPacket*>(getPayload(tsPacket));
+        const int64_t dts = (pesPacket->flagsLo & 0xc0) == 0xc0 ? pesPacket->getDts() : pts;
+        firstPts.emplace(pid, pts);
+        if (firstDts.emplace(pid, dts).second == false && frameLen.find(pid) == frameLen.end() &&
+            ptsDiff(dts, firstDts[pid]) > 0)
+            frameLen[pid] = ptsDiff(dts, firstDts[pid]);
+        setLastPts(pid, pts);
+        if (minPts == -1 || ptsDiff(pts, minPts) < 0)
+            minPts = pts;
+        if (isVideo(pid) && (minVideoPts == -1 || ptsDiff(pts, minVideoPts) < 0))
+            minVideoPts = pts;
+    }
+
+    void setLastPts(const int pid, const int64_t pts)
+    {
+        const auto itr = lastPts.find(pid);
+        if (itr == lastPts.end() || ptsDiff(pts, itr->second) > 0)
+            lastPts[pid] = pts;
+        if (maxPts == -1 || ptsDiff(pts, maxPts) > 0)
+            maxPts = pts;
+        if (isVideo(pid) && (maxVideoPts == -1 || ptsDiff(pts, maxVideoPts) > 0))
+            maxVideoPts = pts;
+    }
+};
+
+// the tracks of the clip and their timestamps at its start and, if there is no clip info file, at its end
+bool readClipInfo(const std::string& fileName, const bool m2tsMode, ClipInfo& clip)
+{
+    File file;
+    if (!file.open(fileName.c_str(), File::ofRead) || !file.size(&clip.fileSize))
+        return false;
+    clip.frameSize = getFrameSize(file, m2tsMode);
+
+    TS_program_association_section pat;
+    bool pmtFound = false;
+    uint8_t pmtBuffer[4096]{0};
+    int pmtBufferLen = 0;
+    forEachTSPacket(file, 0, SEEK_HEAD_SCAN_SIZE, clip.frameSize,
+                    [&](TSPacket* tsPacket, int64_t)
+                    {
+                        const int pid = tsPacket->getPID();
+                        const int payloadLen = TS_FRAME_SIZE - tsPacket->getHeaderSize();
+                        if (payloadLen <= 0)
+                            return true;
+                        if (pid == 0)
+                            pat.deserialize(getPayload(tsPacket), payloadLen);
+                        else if (pat.pmtPids.find(pid) != pat.pmtPids.end())
+                        {
+                            if (!pmtFound && (tsPacket->payloadStart || pmtBufferLen > 0) &&
+                                pmtBufferLen + payloadLen <= static_cast<int>(sizeof(pmtBuffer)))
+                            {
+                                memcpy(pmtBuffer + pmtBufferLen, getPayload(tsPacket), payloadLen);
+                                pmtBufferLen += payloadLen;
+                                if (TS_program_map_section::isFullBuff(pmtBuffer, pmtBufferLen))
+                                    pmtFound = clip.pmt.deserialize(pmtBuffer, pmtBufferLen);
+                            }
+                        }
+                        else if (pmtFound && isPesStart(tsPacket))
+                            clip.addPes(tsPacket);
+                        return true;
+                    });
+    if (!pmtFound)
+        return false;
+
+    CLPIParser clpi;
+    if (loadClipInfo(fileName, clpi) && clpi.presentation_end_time > clpi.presentation_start_time)
+    {
+        clip.clpiDuration = static_cast<int64_t>(clpi.presentation_end_time - clpi.presentation_start_time) * 2;
+        return true;
+    }
+    int64_t tailPos = FFMAX(clip.fileSize - SEEK_TAIL_SCAN_SIZE, SEEK_HEAD_SCAN_SIZE);
+    tailPos -= tailPos % clip.frameSize;
+    forEachTSPacket(file, tailPos, SEEK_TAIL_SCAN_SIZE, clip.frameSize,
+                    [&](TSPacket* tsPacket, int64_t)
+                    {
+                        if (isPesStart(tsPacket) && getPesPts(tsPacket) != -1)
+                            clip.setLastPts(tsPacket->getPID(), getPesPts(tsPacket));
+                        return true;
+                    });
+    return true;
+}
+
+// the first PCR found after the file offset or -1
+int64_t getNextPCR(const File& file, const int64_t pos, const int frameSize)
+{
+    int64_t pcr = -1;
+    forEachTSPacket(file, pos, SEEK_READ_SIZE, frameSize,
+                    [&](TSPacket* tsPacket, int64_t)
+                    {
+                        if (tsPacket->afExists && tsPacket->adaptiveField.length && tsPacket->adaptiveField.pcrExist)
+                            pcr = tsPacket->adaptiveField.getPCR33();
+                        return pcr == -1;
+                    });
+    return pcr;
+}
+
+// the offset of a packet before the PCR value, found by bisection
+int64_t findPCRPosition(const File& file, const int64_t fileSize, const int frameSize, const int64_t pcr)
+{
+    int64_t lo = 0;
+    int64_t hi = fileSize / frameSize;
+    while (hi - lo > SEEK_READ_SIZE / frameSize)
+    {
+        const int64_t mid = (lo + hi) / 2;
+        const int64_t midPcr = getNextPCR(file, mid * frameSize, frameSize);
+        if (midPcr != -1 && ptsDiff(midPcr, pcr) < 0)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo * frameSize;
+}
+}  // namespace
+
+bool TSDemuxer::seekToTime(std::map<int32_t, int64_t>& times)
+{
+    const auto fileList = dynamic_cast<FileListIterator*>(m_fileIterator);
+    if (!m_firstDemuxCall || times.empty() || !m_pidFilters.empty() || (m_fileIterator && !fileList) ||
+        strEndWith(m_streamNameLow, "ssif") || isPipeInput(m_streamName.c_str()))
+        return false;
+
+    // the clip which contains the time, MPLS and multi-file inputs are joined from several ones. The time each track
+    // starts from in the clip is the time its stream reader counts for the previous clips
+    const vector<string> files = fileList ? fileList->getFiles() : vector<string>{m_streamName};
+    std::map<int, int64_t> trackStart;
+    int64_t clipStart = 0;
+    size_t clipIdx = 0;
+    ClipInfo clip;
+    for (;; ++clipIdx)
+    {
+        clip = ClipInfo();
+        if (!readClipInfo(files[clipIdx], m_m2tsMode, clip))
+            return false;
+        bool clipPassed = clipIdx + 1 < files.size();
+        for (const auto& [pid, time] : times)
+        {
+            const auto streamInfo = clip.pmt.pidList.find(pid);
+            if (streamInfo == clip.pmt.pidList.end() || clip.firstPts.find(pid) == clip.firstPts.end())
+                return false;
+            if (streamInfo->second.m_streamType != StreamType::SUB_PGS &&
+                trackStart[pid] + clip.getTrackDuration(pid) > internalClockToPts(time))
+                clipPassed = false;
+        }
+        if (!clipPassed)
+            break;
+        for (const auto& [pid, time] : times)
+        {
+            if (clip.pmt.pidList[pid].m_streamType == StreamType::SUB_PGS)
+                continue;
+            const int64_t duration = clip.getTrackDuration(pid);
+            if (duration <= 0)
+                return false;
+            trackStart[pid] += duration;
+        }
+        // the same time simpleDemuxBlock() adds for the clip, a play item is counted by its IN and OUT times
+        if (clipIdx < m_mplsInfo.size())
+            clipStart +=
+                static_cast<int64_t>(m_mplsInfo[clipIdx].OUT_time - m_mplsInfo[clipIdx].IN_time) * 2;  // in 90Khz clock
+        else
+            clipStart += clip.getDuration();
+    }
+
+    // the video track defines the seek point, PGS keeps its own timestamps and isn't checked against the time
+    int mainPid = -1;
+    std::map<int, int64_t> targets;
+    for (const auto& [pid, time] : times)
+    {
+        const StreamType streamType = clip.pmt.pidList[pid].m_streamType;
+        if (isVideoPID(streamType))
+        {
+            if (mainPid != -1)
+                return false;
+            mainPid = pid;
+        }
+        if (streamType != StreamType::SUB_PGS)
+            targets[pid] = clip.firstPts[pid] + internalClockToPts(time) - trackStart[pid];
+    }
+    if (targets.empty())
+        return false;
+    auto minTarget = targets.begin();
+    for (auto itr = targets.begin(); itr != targets.end(); ++itr)
+        if (ptsDiff(itr->second, minTarget->second) < 0)
+            minTarget = itr;
+    if (mainPid == -1)
+        mainPid = minTarget->first;
+    const StreamType mainType = clip.pmt.pidList[mainPid].m_streamType;
+    const int frameSize = clip.frameSize;
+    File file;
+    if (!file.open(files[clipIdx].c_str(), File::ofRead))
+        return false;
+
+    // the seek points: the entry points of the clip info or the positions found by PCR with a growing margin
+    vector<int64_t> seekPoints;
+    CLPIParser clpi;
+    const bool epMode = frameSize != TS_FRAME_SIZE && loadClipInfo(files[clipIdx], clpi) &&
+                        clpi.m_epMap.find(mainPid) != clpi.m_epMap.end();
+    if (epMode)
+    {
+        const vector<BluRayEPEntry>& entries = clpi.m_epMap[mainPid];
+        const int64_t target = minTarget->second;
+        auto itr = std::find_if(entries.begin(), entries.end(),
+                                [&](const BluRayEPEntry& entry) { return ptsDiff(entry.m_pts, target) > 0; });
+        for (int i = 0; i < MAX_SEEK_TRIES && itr != entries.begin(); ++i)
+            seekPoints.push_back(static_cast<int64_t>((--itr)->m_spn) * frameSize);
+    }
+    else
+    {
+        for (int i = 0; i < MAX_SEEK_TRIES; ++i)
+        {
+            seekPoints.push_back(findPCRPosition(file, clip.fileSize, frameSize, minTarget->second - (90000LL << i)));
+            if (seekPoints.back() == 0)
+                break;
+        }
+    }
+
+    const int64_t mainTarget = targets[mainPid];
+    for (const int64_t seekPoint : seekPoints)
+    {
+        // the first PES packet of each track after the start of the first key frame of the main track
+        int64_t start = -1;
+        std::map<int, int64_t> startPts;
+        bool keyFrameFound = false;
+        bool frameComplete = false;
+        vector<uint8_t> frameData;
+        forEachTSPacket(file, seekPoint, MAX_SEEK_SCAN_SIZE, frameSize,
+                        [&](TSPacket* tsPacket, const int64_t offset)
+                        {
+                            const int pid = tsPacket->getPID();
+                            const bool pesStart = isPesStart(tsPacket);
+                            if (times.find(pid) == times.end() || (start == -1 && (pid != mainPid || !pesStart)))
+                                return true;
+                            if (start != -1 && pid == mainPid && pesStart)
+                            {
+                                if (keyFrameFound ||
+                                    isKeyFrame(mainType, frameData.data(), frameData.data() + frameData.size()))
+                                {
+                                    keyFrameFound = true;
+                                    frameComplete = true;
+                                }
+                                else
+                                {
+                                    // the frame can't be decoded on its own, the tracks start from a later one
+                                    start = -1;
+                                    startPts.clear();
+                                    frameData.clear();
+                                }
+                            }
+                            if (start == -1)
+                            {
+                                // the frames after the target time are of no use, an earlier seek point is tried
+                                if (getPesPts(tsPacket) != -1 && ptsDiff(getPesPts(tsPacket), mainTarget) > 0)
+                                    return false;
+                                start = offset;
+                                keyFrameFound = epMode || !isVideoPID(mainType) ||
+                                                (tsPacket->afExists && tsPacket->adaptiveField.length &&
+                                                 tsPacket->adaptiveField.randomAccessIndicator);
+                            }
+                            if (pesStart)
+                                startPts.emplace(pid, getPesPts(tsPacket));
+                            if (pid == mainPid && !frameComplete && frameData.size() < KEY_FRAME_PROBE_SIZE)
+                            {
+                                uint8_t* payload = getPayload(tsPacket);
+                                uint8_t* end = reinterpret_cast<uint8_t*>(tsPacket) + TS_FRAME_SIZE;
+                                if (pesStart)
+                                    payload += reinterpret_cast<PESPacket*>(payload)->getHeaderLength();
+                                if (payload < end)
+                                    frameData.insert(frameData.end(), payload, end);
+                            }
+                            return startPts.size() < times.size() || !keyFrameFound;
+                        });
+        if (start == -1 || startPts.size() < times.size() ||
+            (!keyFrameFound && !isKeyFrame(mainType, frameData.data(), frameData.data() + frameData.size())))
+            continue;
+
+        // each track must start before the time it's needed from
+        std::map<int32_t, int64_t> newTimes;
+        bool tracksReady = true;
+        for (const auto& [pid, time] : times)
+        {
+            const int64_t pts = startPts[pid];
+            const auto target = targets.find(pid);
+            if (pts == -1)
+                tracksReady = false;
+            else if (target != targets.end())
+            {
+                const int64_t trackTime = trackStart[pid] + ptsDiff(pts, clip.firstPts[pid]);
+                if (trackTime <= 0 || ptsDiff(pts, target->second) > 0)
+                    tracksReady = false;
+                newTimes[pid] = ptsToInternalClock(trackTime);
+            }
+        }
+        if (!tracksReady)
+            continue;
+
+        file.close();
+        if (clipIdx > 0)
+        {
+            if (!m_bufferedReader->openStream(m_readerID, files[clipIdx].c_str()))
+            {
+                m_bufferedReader->openStream(m_readerID, m_streamName.c_str());
+                return false;
+            }
+            fileList->setCurrentFile(clipIdx);
+        }
+        if (!m_bufferedReader->gotoByte(m_readerID, start))
+            return false;
+
+        m_curFileNum = static_cast<uint32_t>(clipIdx);
+        m_prevFileLen = clipStart;
+        m_firstPTS = clip.minPts;
+        m_firstVideoPTS = clip.minVideoPts;
+        m_pmt = clip.pmt;
+        m_nonMVCVideoFound = clip.pmt.video_type != static_cast<int>(StreamType::VIDEO_MVC);
+        for (const auto& [pid, time] : times) m_pesStartPids.insert(pid);
+        times = newTimes;
+        return true;
+    }
+    return false;
+}
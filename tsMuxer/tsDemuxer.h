@@ -37,6 +37,8 @@ class TSDemuxer final : public AbstractDemuxer
     }
     void setMPLSInfo(const std::vector<MPLSPlayItem>& mplsInfo) { m_mplsInfo = mplsInfo; }
     [[nodiscard]] int64_t getFileDurationNano() const override;
+    bool seekToTime(std::map<int32_t, int64_t>& times) override;
+    static bool isVideoPID(StreamType streamType);
 
    private:
     [[nodiscard]] bool mvcContinueExpected() const;
@@ -80,12 +82,13 @@ class TSDemuxer final : public AbstractDemuxer
     std::vector<MPLSPlayItem> m_mplsInfo;
     int64_t m_lastPCRVal;
     bool m_nonMVCVideoFound;
+    FileNameIterator* m_fileIterator;
+    std::set<int> m_pesStartPids;  // the tracks which are read from their next PES header after a seek
 
     // cache to improve speed
     uint8_t m_acceptedPidCache[8192];
     bool m_firstDemuxCall;
 
-    static bool isVideoPID(StreamType streamType);
     bool checkForRealM2ts(const uint8_t* buffer, const uint8_t* end) const;
 };
 
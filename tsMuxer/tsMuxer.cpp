@@ -135,7 +135,7 @@ void TSMuxer::internalReset() { m_outBufLen = 0; }
 
 TSMuxer::~TSMuxer()
 {
-    delete[] m_outBuf;
+    freeIoBuffer(m_outBuf);
     if (!m_isExternalFile)
         delete m_muxFile;
 }
@@ -434,7 +434,7 @@ bool TSMuxer::doFlush(const int64_t newPCR, const int64_t pcrGAP)
         if (lastBlockSize > 0)
         {
             assert(m_sectorSize == 0);  // we should not be here in interleaved mode!
-            const auto newBuff = new uint8_t[lastBlockSize];
+            const auto newBuff = m_owner->writeBufferPool().acquire();
             memcpy(newBuff, m_outBuf + roundBufLen, lastBlockSize);
             m_owner->asyncWriteBuffer(this, m_outBuf, roundBufLen, m_muxFile);
             m_outBuf = newBuff;
@@ -525,7 +525,7 @@ void TSMuxer::processM2TSPCR(const int64_t pcrVal, const int64_t pcrGAP)
             else
             {
                 m_owner->syncWriteBuffer(this, i.first, i.second, m_muxFile);
-                delete[] i.first;
+                m_owner->writeBufferPool().release(i.first);
             }
             offset = j - i.second;
         }
@@ -875,12 +875,15 @@ void TSMuxer::flushTSBuffer()
         THROW(ERR_FILE_COMMON, "Can't determine size for file " << m_outFileName)
     m_muxFile->close();
 
-    if (!m_muxFile->open(m_outFileName.c_str(), File::ofWrite + File::ofAppend))
+    unsigned oflag = File::ofWrite + File::ofAppend;
+    if (m_owner->useDirectIo())
+        oflag += File::ofDirect;
+    if (!m_muxFile->open(m_outFileName.c_str(), oflag))
         THROW(ERR_FILE_COMMON, "Can't reopen file " << m_outFileName)
 
     if (writeOutFile(m_outBuf, m_outBufLen) != m_outBufLen)
         THROW(ERR_FILE_COMMON, "Can't write last data block to file " << m_outFileName)
-    delete[] m_outBuf;
+    freeIoBuffer(m_outBuf);
     m_outBufLen = 0;
 }
 
@@ -898,7 +901,7 @@ void TSMuxer::finishFileBlock(const int64_t newPts, const int64_t newPCR, const
             assert(m_outBuf == nullptr && m_outBufLen == 0);
         else
             flushTSBuffer();
-        m_outBuf = new uint8_t[m_writeBlockSize + 1024];
+        m_outBuf = m_owner->writeBufferPool().acquire();
         m_prevM2TSPCROffset = 0;
     }
 
@@ -1282,7 +1285,7 @@ void TSMuxer::writeOutBuffer()
         int toFileLen = m_writeBlockSize & ~(MuxerManager::PHYSICAL_SECTOR_SIZE - 1);
         if (m_owner->isAsyncMode())
         {
-            const auto newBuf = new uint8_t[m_writeBlockSize + 1024];
+            const auto newBuf = m_owner->writeBufferPool().acquire();
             memcpy(newBuf, m_outBuf + toFileLen, m_outBufLen - toFileLen);
             if (m_m2tsMode)
             {
@@ -1311,7 +1314,7 @@ void TSMuxer::writeOutBuffer()
                 }
                 else
                 {
-                    auto newBuf = new uint8_t[toFileLen];
+                    auto newBuf = m_owner->writeBufferPool().acquire();
                     memcpy(newBuf, m_outBuf, toFileLen);
                     m_m2tsDelayBlocks.emplace_back(newBuf, toFileLen);
                 }
@@ -1412,15 +1415,24 @@ void TSMuxer::setMasterMode(AbstractMuxer* subMuxer, const bool flushInterleaved
 
 void TSMuxer::openDstFile()
 {
-    m_muxFile = m_fileFactory ? m_fileFactory->createFile() : new File();
+    if (m_outFileName == STDOUT_FILE_NAME)
+        m_muxFile = new StdoutStream();
+    else
+        m_muxFile = m_fileFactory ? m_fileFactory->createFile() : new File();
 
     int systemFlags = 0;
 #ifdef _WIN32
     if (m_owner->isAsyncMode())
         systemFlags += FILE_FLAG_NO_BUFFERING;
 #endif
-    if (!m_muxFile->open(m_outFileName.c_str(), File::ofWrite, systemFlags))
+    unsigned oflag = File::ofWrite;
+    if (m_owner->useDirectIo())
+        oflag += File::ofDirect;
+    if (!m_muxFile->open(m_outFileName.c_str(), oflag, systemFlags))
         THROW(ERR_CANT_CREATE_FILE, "Can't create file " << m_outFileName)
+    m_muxFile->setWriteback(m_owner->writebackWindow());
+    // a split file is expected to reach the split size, otherwise the output is about as large as the input
+    m_muxFile->preallocate(m_splitSize > 0 ? m_splitSize : m_owner->totalSize());
 }
 
 vector<int64_t> TSMuxer::getFirstPts() const
@@ -1452,6 +1464,8 @@ vector<int64_t> TSMuxer::getLastPts() const
 void TSMuxer::setFileName(const std::string& fileName, FileFactory* fileFactory)
 {
     m_curFileNum = 0;
+    if (fileName == STDOUT_FILE_NAME && (m_splitSize > 0 || m_splitDuration > 0))
+        THROW(ERR_COMMON, "The output can't be split when it is written to stdout")
     AbstractMuxer::setFileName(fileName, fileFactory);
     m_outFileName = getNextName(fileName);
     const string ext = strToUpperCase(extractFileExt(m_outFileName));
@@ -1473,7 +1487,7 @@ void TSMuxer::setMuxFormat(const std::string& format)
 {
     m_m2tsMode = format == "M2TS" || format == "M2T" || format == "MTS" || format == "SSIF";
     m_writeBlockSize = m_m2tsMode ? DEFAULT_FILE_BLOCK_SIZE : TS188_ROUND_BLOCK_SIZE;
-    m_outBuf = new uint8_t[m_writeBlockSize + 1024];
+    m_outBuf = m_owner->writeBufferPool().acquire();
     m_frameSize = m_m2tsMode ? 192 : 188;
     if (m_m2tsMode)
         m_sectorSize = 1024 * 6;
@@ -772,11 +772,73 @@ void CLPIParser::parseCPI(uint8_t* buffer, const uint8_t* end)
 {
     BitStreamReader reader{};
     reader.setBuffer(buffer, end);
-    if (reader.getBits(32) != 0)  // length
-        reader.skipBits(16);      // reserved_for_word_align, CPI_type (1 is typical value)
+    if (reader.getBits(32) == 0)  // length
+        return;
+    reader.skipBits(12);                  // reserved_for_word_align
+    if (reader.getBits<uint8_t>(4) == 1)  // CPI_type
+        EP_map(buffer + 6, end);
 }
 
-void CLPIParser::EP_map(BitStreamReader& reader) {}
+void CLPIParser::EP_map(uint8_t* buffer, const uint8_t* end)
+{
+    struct StreamEntry
+    {
+        int pid;
+        uint32_t coarseEntries;
+        uint32_t fineEntries;
+        uint32_t startAddress;
+    };
+
+    BitStreamReader reader{};
+    reader.setBuffer(buffer, end);
+    reader.skipBits(8);  // reserved_for_word_align
+    const auto number_of_stream_PID_entries = reader.getBits<uint8_t>(8);
+    std::vector<StreamEntry> streams;
+    for (uint8_t k = 0; k < number_of_stream_PID_entries; k++)
+    {
+        StreamEntry stream{};
+        stream.pid = reader.getBits<int>(16);  // stream_PID[k]
+        reader.skipBits(10);                   // reserved_for_word_align
+        reader.skipBits(4);                    // EP_stream_type[k]
+        stream.coarseEntries = reader.getBits(16);
+        stream.fineEntries = reader.getBits(18);
+        stream.startAddress = reader.getBits(32);  // EP_map_for_one_stream_PID_start_address[k]
+        streams.push_back(stream);
+    }
+
+    for (const StreamEntry& stream : streams)
+    {
+        uint8_t* streamStart = buffer + stream.startAddress;
+        reader.setBuffer(streamStart, end);
+        const uint32_t EP_fine_table_start_address = reader.getBits(32);
+        // the first fine entry and the high bits of the PTS and the SPN of each coarse entry
+        std::vector<BluRayCoarseInfo> coarseInfo;
+        for (uint32_t i = 0; i < stream.coarseEntries; i++)
+        {
+            const uint32_t fineRefID = reader.getBits(18);  // ref_to_EP_fine_id[i]
+            const uint32_t coarsePts = reader.getBits(14);  // PTS_EP_coarse[i]
+            const uint32_t pktCnt = reader.getBits(32);     // SPN_EP_coarse[i]
+            coarseInfo.emplace_back(coarsePts, fineRefID, pktCnt);
+        }
+
+        if (coarseInfo.empty())
+            continue;
+
+        reader.setBuffer(streamStart + EP_fine_table_start_address, end);
+        std::vector<BluRayEPEntry>& entries = m_epMap[stream.pid];
+        size_t coarseIdx = 0;
+        for (uint32_t i = 0; i < stream.fineEntries; i++)
+        {
+            reader.skipBits(4);                           // is_angle_change_point, I_end_position_offset
+            const uint32_t ptsFine = reader.getBits(11);  // PTS_EP_fine[EP_fine_id]
+            const uint32_t spnFine = reader.getBits(17);  // SPN_EP_fine[EP_fine_id]
+            while (coarseIdx + 1 < coarseInfo.size() && coarseInfo[coarseIdx + 1].m_fineRefID <= i) coarseIdx++;
+            const BluRayCoarseInfo& coarse = coarseInfo[coarseIdx];
+            const int64_t pts = static_cast<int64_t>(coarse.m_coarsePts) << 19 | static_cast<int64_t>(ptsFine) << 9;
+            entries.push_back({pts, (coarse.m_pktCnt & 0xfffe0000) | spnFine});
+        }
+    }
+}
 
 void CLPIParser::composeCPI(BitStreamWriter& writer, const bool isCPIExt)
 {
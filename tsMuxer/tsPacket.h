@@ -216,6 +216,13 @@ struct BluRayCoarseInfo
     }
 };
 
+//! An entry point of a clip: the PTS of a key frame and the source packet its data starts at
+struct BluRayEPEntry
+{
+    int64_t m_pts;  // 90KHz clock, the lowest 9 bits are not stored in the EP map
+    uint32_t m_spn;
+};
+
 struct PMTIndexData
 {
     uint32_t m_pktCnt;
@@ -453,18 +460,19 @@ class CLPIParser
     std::vector<uint32_t> SPN_extent_start;
     std::vector<int32_t> interleaveInfo;
     bool isDependStream;
+    std::map<int, std::vector<BluRayEPEntry>> m_epMap;  // entry points of the clip by stream PID, sorted by PTS
 
    private:
     static void HDMV_LPCM_down_mix_coefficient(uint8_t* buffer, unsigned dataLength);
     void Extent_Start_Point(uint8_t* buffer, unsigned dataLength);
     void ProgramInfo_SS(uint8_t* buffer, unsigned dataLength);
-    static void CPI_SS(uint8_t* buffer, unsigned dataLength);
+    void CPI_SS(uint8_t* buffer, unsigned dataLength);
 
     static void parseProgramInfo(uint8_t* buffer, const uint8_t* end, std::vector<CLPIProgramInfo>& programInfoMap,
                                  std::map<int, CLPIStreamInfo>& streamInfoMap);
     void parseSequenceInfo(uint8_t* buffer, const uint8_t* end);
-    static void parseCPI(uint8_t* buffer, const uint8_t* end);
-    static void EP_map(BitStreamReader& reader);
+    void parseCPI(uint8_t* buffer, const uint8_t* end);
+    void EP_map(uint8_t* buffer, const uint8_t* end);
     static void parseClipMark(uint8_t* buffer, const uint8_t* end);
     void parseClipInfo(BitStreamReader& reader);
     void parseExtensionData(uint8_t* buffer, const uint8_t* end);
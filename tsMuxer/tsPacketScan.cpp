@@ -0,0 +1,215 @@
+#include "tsPacketScan.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define TS_SCAN_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TS_SCAN_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+constexpr uint8_t SYNC_BYTE = 0x47;
+
+// the first 4 bytes of a packet as a little endian word: sync byte, PUSI and the high PID bits, the low PID bits,
+// the adaptation field control and the continuity counter
+constexpr uint32_t SYNC_MASK = 0xff;
+constexpr uint32_t PID_HI_MASK = 0x1f00;
+constexpr uint32_t PAYLOAD_START_MASK = 0x4000;
+constexpr uint32_t AF_EXISTS_MASK = 0x20000000;
+
+using ScanFunc = int (*)(const uint8_t* data, int count, int stride, TSPacketHeader* headers);
+
+int scanScalar(const uint8_t* data, const int count, const int stride, TSPacketHeader* headers)
+{
+    for (int i = 0; i < count; ++i, data += stride)
+    {
+        if (data[0] != SYNC_BYTE)
+            return i;
+        headers[i].pid = static_cast<uint16_t>((data[1] & 0x1f) << 8 | data[2]);
+        headers[i].headerSize = static_cast<uint16_t>(4 + (data[3] & 0x20 ? data[4] + 1 : 0));
+        headers[i].payloadStart = data[1] & 0x40;
+    }
+    return count;
+}
+
+#if defined(TS_SCAN_X86) || defined(TS_SCAN_NEON)
+uint32_t loadHeader(const uint8_t* packet)
+{
+    uint32_t rez;
+    memcpy(&rez, packet, sizeof(rez));
+    return rez;
+}
+
+// copy the fields computed for a group of packets into the headers
+template <int N>
+void storeHeaders(const uint32_t* pid, const uint32_t* headerSize, const uint32_t* payloadStart,
+                  TSPacketHeader* headers)
+{
+    for (int i = 0; i < N; ++i)
+    {
+        headers[i].pid = static_cast<uint16_t>(pid[i]);
+        headers[i].headerSize = static_cast<uint16_t>(headerSize[i]);
+        headers[i].payloadStart = payloadStart[i] != 0;
+    }
+}
+#endif
+
+#ifdef TS_SCAN_X86
+// 4 packets at once. The headers are loaded one by one, as SSE2 can't gather
+int scanSse2(const uint8_t* data, const int count, const int stride, TSPacketHeader* headers)
+{
+    const __m128i syncMask = _mm_set1_epi32(SYNC_MASK);
+    const __m128i sync = _mm_set1_epi32(SYNC_BYTE);
+    const __m128i pidHiMask = _mm_set1_epi32(PID_HI_MASK);
+    const __m128i byteMask = _mm_set1_epi32(0xff);
+    const __m128i payloadStartMask = _mm_set1_epi32(PAYLOAD_START_MASK);
+    const __m128i afExistsMask = _mm_set1_epi32(AF_EXISTS_MASK);
+    const __m128i four = _mm_set1_epi32(4);
+    const __m128i one = _mm_set1_epi32(1);
+    alignas(16) uint32_t pid[4];
+    alignas(16) uint32_t headerSize[4];
+    alignas(16) uint32_t payloadStart[4];
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const uint8_t* p = data + i * stride;
+        const __m128i hdr = _mm_setr_epi32(static_cast<int>(loadHeader(p)), static_cast<int>(loadHeader(p + stride)),
+                                           static_cast<int>(loadHeader(p + 2 * stride)),
+                                           static_cast<int>(loadHeader(p + 3 * stride)));
+        const __m128i syncOk = _mm_cmpeq_epi32(_mm_and_si128(hdr, syncMask), sync);
+        if (_mm_movemask_ps(_mm_castsi128_ps(syncOk)) != 0xf)
+            break;
+        const __m128i afLen = _mm_setr_epi32(p[4], p[stride + 4], p[2 * stride + 4], p[3 * stride + 4]);
+        const __m128i afExists = _mm_cmpeq_epi32(_mm_and_si128(hdr, afExistsMask), afExistsMask);
+        _mm_store_si128(reinterpret_cast<__m128i*>(pid),
+                        _mm_or_si128(_mm_and_si128(hdr, pidHiMask), _mm_and_si128(_mm_srli_epi32(hdr, 16), byteMask)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(headerSize),
+                        _mm_add_epi32(four, _mm_and_si128(afExists, _mm_add_epi32(afLen, one))));
+        _mm_store_si128(reinterpret_cast<__m128i*>(payloadStart), _mm_and_si128(hdr, payloadStartMask));
+        storeHeaders<4>(pid, headerSize, payloadStart, headers + i);
+    }
+    return i + scanScalar(data + i * stride, count - i, stride, headers + i);
+}
+
+// 8 packets at once, the headers and the adaptation field lengths are gathered
+TARGET_AVX2 int scanAvx2(const uint8_t* data, const int count, const int stride, TSPacketHeader* headers)
+{
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+    const __m256i syncMask = _mm256_set1_epi32(SYNC_MASK);
+    const __m256i sync = _mm256_set1_epi32(SYNC_BYTE);
+    const __m256i pidHiMask = _mm256_set1_epi32(PID_HI_MASK);
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    const __m256i payloadStartMask = _mm256_set1_epi32(PAYLOAD_START_MASK);
+    const __m256i afExistsMask = _mm256_set1_epi32(AF_EXISTS_MASK);
+    const __m256i four = _mm256_set1_epi32(4);
+    const __m256i one = _mm256_set1_epi32(1);
+    alignas(32) uint32_t pid[8];
+    alignas(32) uint32_t headerSize[8];
+    alignas(32) uint32_t payloadStart[8];
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const auto p = reinterpret_cast<const int*>(data + i * stride);
+        const __m256i hdr = _mm256_i32gather_epi32(p, offsets, 1);
+        const __m256i syncOk = _mm256_cmpeq_epi32(_mm256_and_si256(hdr, syncMask), sync);
+        if (_mm256_movemask_ps(_mm256_castsi256_ps(syncOk)) != 0xff)
+            break;
+        const __m256i afLen = _mm256_and_si256(_mm256_i32gather_epi32(p + 1, offsets, 1), byteMask);
+        const __m256i afExists = _mm256_cmpeq_epi32(_mm256_and_si256(hdr, afExistsMask), afExistsMask);
+        _mm256_store_si256(
+            reinterpret_cast<__m256i*>(pid),
+            _mm256_or_si256(_mm256_and_si256(hdr, pidHiMask), _mm256_and_si256(_mm256_srli_epi32(hdr, 16), byteMask)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(headerSize),
+                           _mm256_add_epi32(four, _mm256_and_si256(afExists, _mm256_add_epi32(afLen, one))));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(payloadStart), _mm256_and_si256(hdr, payloadStartMask));
+        storeHeaders<8>(pid, headerSize, payloadStart, headers + i);
+    }
+    return i + scanSse2(data + i * stride, count - i, stride, headers + i);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    // the OS must save the AVX registers
+    constexpr int OSXSAVE = 1 << 27;
+    constexpr int AVX = 1 << 28;
+    if ((info[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX) || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef TS_SCAN_NEON
+// 4 packets at once
+int scanNeon(const uint8_t* data, const int count, const int stride, TSPacketHeader* headers)
+{
+    const uint32x4_t syncMask = vdupq_n_u32(SYNC_MASK);
+    const uint32x4_t sync = vdupq_n_u32(SYNC_BYTE);
+    const uint32x4_t pidHiMask = vdupq_n_u32(PID_HI_MASK);
+    const uint32x4_t byteMask = vdupq_n_u32(0xff);
+    const uint32x4_t payloadStartMask = vdupq_n_u32(PAYLOAD_START_MASK);
+    const uint32x4_t afExistsMask = vdupq_n_u32(AF_EXISTS_MASK);
+    alignas(16) uint32_t buffer[4];
+    alignas(16) uint32_t pid[4];
+    alignas(16) uint32_t headerSize[4];
+    alignas(16) uint32_t payloadStart[4];
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const uint8_t* p = data + i * stride;
+        for (int j = 0; j < 4; ++j) buffer[j] = loadHeader(p + j * stride);
+        const uint32x4_t hdr = vld1q_u32(buffer);
+        if (vminvq_u32(vceqq_u32(vandq_u32(hdr, syncMask), sync)) == 0)
+            break;
+        for (int j = 0; j < 4; ++j) buffer[j] = p[j * stride + 4];
+        const uint32x4_t afLen = vld1q_u32(buffer);
+        const uint32x4_t afExists = vtstq_u32(hdr, afExistsMask);
+        vst1q_u32(pid, vorrq_u32(vandq_u32(hdr, pidHiMask), vandq_u32(vshrq_n_u32(hdr, 16), byteMask)));
+        vst1q_u32(headerSize, vaddq_u32(vdupq_n_u32(4), vandq_u32(afExists, vaddq_u32(afLen, vdupq_n_u32(1)))));
+        vst1q_u32(payloadStart, vandq_u32(hdr, payloadStartMask));
+        storeHeaders<4>(pid, headerSize, payloadStart, headers + i);
+    }
+    return i + scanScalar(data + i * stride, count - i, stride, headers + i);
+}
+#endif
+
+ScanFunc selectScanFunc()
+{
+#if defined(TS_SCAN_X86)
+    return cpuHasAvx2() ? scanAvx2 : scanSse2;
+#elif defined(TS_SCAN_NEON)
+    return scanNeon;
+#else
+    return scanScalar;
+#endif
+}
+}  // namespace
+
+int scanTSPackets(const uint8_t* data, const int count, const int stride, TSPacketHeader* headers)
+{
+    static const ScanFunc scan = selectScanFunc();
+    return scan(data, count, stride, headers);
+}
@@ -0,0 +1,28 @@
+#ifndef TS_PACKET_SCAN_H_
+#define TS_PACKET_SCAN_H_
+
+#include <cstdint>
+
+//! Fields of a TS packet header read by scanTSPackets()
+struct TSPacketHeader
+{
+    uint16_t pid;
+    uint16_t headerSize;  // with the adaptation field. Exceeds the packet size if the adaptation field is broken
+    bool payloadStart;
+};
+
+//! Maximum number of packets passed to scanTSPackets() at once by the demuxers
+constexpr int TS_SCAN_BATCH = 64;
+
+//! Read the headers of packets which follow each other at a fixed distance
+/*!
+        The packets start at data, data + stride, data + 2 * stride and so on. The scan stops at the first packet
+        without a sync byte, so the caller can search for the next one. Sync bytes and headers are checked several at
+        once with SSE2, AVX2 or NEON code chosen at run time.
+        \param count Number of packets. Each of them must be completely inside the buffer
+        \param stride Distance between the packets: 188 for TS, 192 for M2TS
+        \return The number of packets in the run, the headers are stored into headers[0..rez)
+*/
+int scanTSPackets(const uint8_t* data, int count, int stride, TSPacketHeader* headers);
+
+#endif
@@ -40,6 +40,11 @@ class Process
 #define bswap_32(x) my_ntohl(x)
 
 static constexpr unsigned DETECT_STREAM_BUFFER_SIZE = 1024 * 1024 * 64;
+// the track detection starts on that much data and doubles it while the results change
+static constexpr unsigned DETECT_STREAM_MIN_SIZE = 1024 * 1024;
+// the tracks with almost no data in the first DETECT_STREAM_BUFFER_SIZE bytes (sparse subtitles, late audio) are
+// searched up to that size
+static constexpr unsigned DETECT_STREAM_MAX_SIZE = 1024 * 1024 * 256;
 static constexpr unsigned TS_PID_NULL = 8191;
 static constexpr unsigned TS_PID_PAT = 0;
 static constexpr unsigned TS_PID_PMT = 1;